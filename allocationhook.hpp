@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+
+#include "allocations.hpp"
+
+// replaces the C allocation functions of the whole program, including those the compression libraries call, with
+// glibc's own ones that count every allocation of the calling thread in threadAllocations
+// include in a single translation unit of a program only
+
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(std::size_t size) noexcept
+{
+	++threadAllocations.count;
+	threadAllocations.bytes += size;
+	return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+	++threadAllocations.count;
+	threadAllocations.bytes += count * size;
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) noexcept
+{
+	++threadAllocations.count;
+	threadAllocations.bytes += size;
+	return __libc_realloc(pointer, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+	++threadAllocations.count;
+	threadAllocations.bytes += size;
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, std::size_t alignment, std::size_t size) noexcept
+{
+	if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+		return EINVAL;
+
+	*pointer = memalign(alignment, size);
+	return *pointer || size == 0 ? 0 : ENOMEM;
+}
+
+void free(void* pointer) noexcept
+{
+	__libc_free(pointer);
+}
+}
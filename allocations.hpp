@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// heap allocations made by a thread, counted by allocationhook.hpp
+struct AllocationCounts
+{
+	std::size_t count = 0;
+	std::size_t bytes = 0;
+};
+
+// stays zero in programs without the hook
+inline thread_local AllocationCounts threadAllocations;
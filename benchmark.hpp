@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "allocations.hpp"
+#include "chunkcache.hpp"
+#include "histogram.hpp"
+#include "palette.hpp"
+#include "parser.hpp"
+#include "statistics.hpp"
+#include "threadpool.hpp"
+
+template <typename Scheme>
+std::size_t benchmarkRegion(Region const& region, Scheme& scheme)
+{
+	std::size_t size = 0;
+
+	scheme.beginRegion(region);
+
+	for(auto& chunk : region.chunks)
+	{
+		scheme.beginChunk(chunk);
+
+		for(auto section : chunk.sections())
+			size += scheme.section(section);
+
+		size += scheme.endChunk();
+	}
+
+	size += scheme.endRegion();
+	return size;
+}
+
+inline
+std::size_t sectionCount(std::vector<Region> const& regions)
+{
+	std::size_t count = 0;
+
+	for(auto& region : regions)
+		count += region.sections.size();
+
+	return count;
+}
+
+// CPU time consumed by the calling thread, in seconds
+inline
+float threadCpuTime()
+{
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec + time.tv_nsec / 1e9f;
+}
+
+struct BenchmarkResult
+{
+	std::string scheme;
+	// size of the raw sections that went in
+	std::size_t inputSize = 0;
+	std::size_t size = 0;
+	float time = 0;
+	float cpuTime = 0;
+	std::size_t threads = 1;
+	// of the timed repetitions, time and cpuTime are their medians, count is 0 for a single run
+	Statistics timeStatistics;
+	Statistics cpuTimeStatistics;
+	// half widths of the 95% confidence intervals of results extrapolated from a sample, 0 for measured ones
+	double sizeError = 0;
+	double timeError = 0;
+	// heap allocations of single threaded runs and the number of chunks they were made for, 0 if not counted
+	std::size_t allocations = 0;
+	std::size_t allocatedBytes = 0;
+	std::size_t chunkCount = 0;
+};
+
+inline
+void printResult(BenchmarkResult const& result)
+{
+	std::printf("scheme: %s\n", result.scheme.c_str());
+	std::printf("size: %.2f MiB\n", result.size / 1024.f / 1024.f);
+	std::printf("time: %.2f s\n", result.time);
+	std::printf("cpu time: %.2f s\n", result.cpuTime);
+
+	if(result.sizeError != 0 || result.timeError != 0)
+	{
+		std::printf("extrapolated: size %.2f +- %.2f MiB (%.1f%%), time %.2f +- %.2f s (%.1f%%)\n",
+		            result.size / 1024. / 1024., result.sizeError / 1024. / 1024., result.size == 0 ? 0. : 100 * result.sizeError / result.size,
+		            result.time, result.timeError, result.time == 0 ? 0. : 100 * result.timeError / result.time);
+	}
+
+	if(result.timeStatistics.count > 1)
+	{
+		auto& time = result.timeStatistics;
+		std::printf("%zu runs: median %.4f s, mean %.4f s +- %.4f s (95%% ci), stddev %.4f s (%.1f%%), min %.4f s, max %.4f s\n",
+		            time.count, time.median, time.mean, time.confidence, time.stddev, time.mean == 0 ? 0. : 100 * time.stddev / time.mean,
+		            time.min, time.max);
+	}
+
+	if(result.size != 0 && result.time != 0)
+		std::printf("ratio: %.2f, speed: %.2f MiB/s\n", (float)result.inputSize / result.size, result.inputSize / 1024.f / 1024.f / result.time);
+
+	if(result.chunkCount != 0)
+		std::printf("allocations: %.2f per chunk, %.0f bytes per chunk\n", (double)result.allocations / result.chunkCount,
+		            (double)result.allocatedBytes / result.chunkCount);
+
+	std::printf("\n");
+}
+
+// adds the measurements of a run over another part of the world
+inline
+void accumulate(BenchmarkResult& total, BenchmarkResult const& part)
+{
+	total.scheme = part.scheme;
+	total.inputSize += part.inputSize;
+	total.size += part.size;
+	total.time += part.time;
+	total.cpuTime += part.cpuTime;
+	total.allocations += part.allocations;
+	total.allocatedBytes += part.allocatedBytes;
+	total.chunkCount += part.chunkCount;
+}
+
+template <typename Scheme>
+BenchmarkResult benchmark(std::vector<Region> const& regions, Scheme scheme)
+{
+	auto startAllocations = threadAllocations;
+	auto startTime = std::chrono::steady_clock::now();
+	auto startCpuTime = threadCpuTime();
+
+	std::size_t size = 0;
+
+	for(auto& region : regions)
+		size += benchmarkRegion(region, scheme);
+
+	auto endCpuTime = threadCpuTime();
+	auto endTime = std::chrono::steady_clock::now();
+	auto endAllocations = threadAllocations;
+
+	BenchmarkResult result;
+	result.scheme = scheme.name();
+	result.inputSize = sectionCount(regions) * BLOCKS_PER_SECTION * sizeof(std::uint16_t);
+	result.size = size;
+	result.time = std::chrono::duration<float>(endTime - startTime).count();
+	result.cpuTime = endCpuTime - startCpuTime;
+	result.allocations = endAllocations.count - startAllocations.count;
+	result.allocatedBytes = endAllocations.bytes - startAllocations.bytes;
+
+	for(auto& region : regions)
+		result.chunkCount += region.chunks.size();
+
+	return result;
+}
+
+struct Repetitions
+{
+	// untimed runs that fault in the input and warm the caches, branch predictors and cpu clock first
+	std::size_t warmup = 0;
+	std::size_t count = 1;
+};
+
+// runs a benchmark repeatedly and reports the median times, along with the spread of the timed runs
+// sizes don't change between runs, so they are taken from the last one
+template <typename Run>
+BenchmarkResult repeatBenchmark(Repetitions const& repetitions, Run run)
+{
+	for(std::size_t i = 0; i != repetitions.warmup; ++i)
+		run();
+
+	BenchmarkResult result;
+	std::vector<double> times;
+	std::vector<double> cpuTimes;
+
+	for(std::size_t i = 0; i != repetitions.count; ++i)
+	{
+		result = run();
+		times.push_back(result.time);
+		cpuTimes.push_back(result.cpuTime);
+	}
+
+	if(repetitions.count == 1)
+		return result;
+
+	result.timeStatistics = summarize(times);
+	result.cpuTimeStatistics = summarize(cpuTimes);
+	result.time = result.timeStatistics.median;
+	result.cpuTime = result.cpuTimeStatistics.median;
+	return result;
+}
+
+// feeds the cached chunk payloads straight to the scheme's compressor, so only the compressor is measured
+template <typename Scheme>
+BenchmarkResult benchmarkCached(ChunkCache const& cache, Scheme scheme)
+{
+	auto startAllocations = threadAllocations;
+	auto startTime = std::chrono::steady_clock::now();
+	auto startCpuTime = threadCpuTime();
+
+	std::size_t size = 0;
+
+	for(std::size_t i = 0; i != cache.chunkCount(); ++i)
+		size += scheme.compressPayload(cache.chunk(i), cache.chunkSize(i));
+
+	auto endCpuTime = threadCpuTime();
+	auto endTime = std::chrono::steady_clock::now();
+	auto endAllocations = threadAllocations;
+
+	BenchmarkResult result;
+	result.scheme = scheme.name();
+	result.inputSize = cache.inputSize();
+	result.size = size;
+	result.time = std::chrono::duration<float>(endTime - startTime).count();
+	result.cpuTime = endCpuTime - startCpuTime;
+	result.allocations = endAllocations.count - startAllocations.count;
+	result.allocatedBytes = endAllocations.bytes - startAllocations.bytes;
+	result.chunkCount = cache.chunkCount();
+	return result;
+}
+
+// runs the scheme with 1, 2, 4, ... up to maxThreads worker threads, each of which owns a separate scheme instance
+// scaling efficiency is relative to the single-threaded run: t(1) / (n * t(n))
+template <typename SchemeFactory>
+std::vector<BenchmarkResult> benchmarkParallel(std::vector<Region> const& regions, std::size_t maxThreads, SchemeFactory makeScheme)
+{
+	std::vector<BenchmarkResult> results;
+	auto inputSize = sectionCount(regions) * BLOCKS_PER_SECTION * sizeof(std::uint16_t);
+
+	std::printf("scheme: %s\n", makeScheme().name().c_str());
+
+	float singleThreadedDuration = 0;
+
+	for(std::size_t threads = 1;; threads = std::min(2 * threads, maxThreads))
+	{
+		std::vector<std::size_t> sizes(threads);
+		WorkStealingRange range(threads, regions.size());
+
+		auto startTime = std::chrono::steady_clock::now();
+		auto startCpuTime = std::clock();
+
+		runWorkers(threads, [&](std::size_t worker)
+		{
+			auto scheme = makeScheme();
+			std::size_t item;
+
+			while(range.next(worker, item))
+				sizes[worker] += benchmarkRegion(regions[item], scheme);
+		});
+
+		auto endCpuTime = std::clock();
+		auto endTime = std::chrono::steady_clock::now();
+		auto duration = std::chrono::duration<float>(endTime - startTime).count();
+		auto cpuDuration = (float)(endCpuTime - startCpuTime) / CLOCKS_PER_SEC;
+
+		std::size_t size = 0;
+
+		for(auto workerSize : sizes)
+			size += workerSize;
+
+		if(threads == 1)
+		{
+			singleThreadedDuration = duration;
+			std::printf("size: %.2f MiB\n", size / 1024.f / 1024.f);
+		}
+
+		auto efficiency = duration == 0 ? 1.f : singleThreadedDuration / (threads * duration);
+		std::printf("threads: %zu, wall: %.2f s, cpu: %.2f s, efficiency: %.1f%%\n", threads, duration, cpuDuration, 100 * efficiency);
+
+		BenchmarkResult result;
+		result.scheme = makeScheme().name();
+		result.inputSize = inputSize;
+		result.size = size;
+		result.time = duration;
+		result.cpuTime = cpuDuration;
+		result.threads = threads;
+		results.push_back(result);
+
+		if(threads == maxThreads)
+			break;
+	}
+
+	std::printf("\n");
+	return results;
+}
+
+// compresses every chunk, then measures decoding all of them and verifies the result against the source sections
+// the result holds the decode time
+template <typename Scheme>
+BenchmarkResult benchmarkDecode(std::vector<Region> const& regions, Scheme scheme)
+{
+	struct EncodedChunk
+	{
+		Chunk const* chunk;
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	std::vector<std::uint8_t> compressed;
+	std::vector<EncodedChunk> encodedChunks;
+	std::size_t inputSize = 0;
+
+	for(auto& region : regions)
+	{
+		scheme.beginRegion(region);
+
+		for(auto& chunk : region.chunks)
+		{
+			scheme.beginChunk(chunk);
+
+			for(auto section : chunk.sections())
+			{
+				scheme.section(section);
+				inputSize += sizeof *section * BLOCKS_PER_SECTION;
+			}
+
+			auto size = scheme.endChunk();
+			encodedChunks.push_back({&chunk, compressed.size(), size});
+			compressed.insert(compressed.end(), scheme.compressedChunk(), scheme.compressedChunk() + size);
+		}
+
+		scheme.endRegion();
+	}
+
+	std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK);
+	std::chrono::steady_clock::duration decodeTime{};
+	std::size_t mismatches = 0;
+
+	for(auto& encoded : encodedChunks)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		scheme.decodeChunk(compressed.data() + encoded.offset, encoded.size, encoded.chunk->sectionCount, decoded.data());
+		decodeTime += std::chrono::steady_clock::now() - startTime;
+
+		auto out = decoded.data();
+
+		for(auto section : encoded.chunk->sections())
+		{
+			if(std::memcmp(section, out, sizeof *out * BLOCKS_PER_SECTION) != 0)
+			{
+				++mismatches;
+				break;
+			}
+
+			out += BLOCKS_PER_SECTION;
+		}
+	}
+
+	auto duration = std::chrono::duration<float>(decodeTime).count();
+
+	std::printf("scheme: %s\n", scheme.name().c_str());
+	std::printf("size: %.2f MiB\n", compressed.size() / 1024.f / 1024.f);
+	std::printf("decode time: %.2f s\n", duration);
+	std::printf("decode speed: %.2f MiB/s\n", duration == 0 ? 0.f : inputSize / 1024.f / 1024.f / duration);
+
+	if(mismatches == 0)
+		std::printf("roundtrip: ok\n");
+	else
+		std::printf("roundtrip: FAILED, %zu of %zu chunks differ from the source\n", mismatches, encodedChunks.size());
+
+	std::printf("\n");
+
+	BenchmarkResult result;
+	result.scheme = scheme.name();
+	result.inputSize = inputSize;
+	result.size = compressed.size();
+	result.time = duration;
+	return result;
+}
+
+// encodes one region at a time and then decodes randomly chosen chunks of it, measuring the latency of a single
+// chunk read from schemes that compress several chunks together
+// the result holds the time of all reads, with the chunks read as the input
+template <typename Scheme>
+BenchmarkResult benchmarkRandomAccess(std::vector<Region> const& regions, Scheme scheme)
+{
+	constexpr std::size_t READS_PER_REGION = 256;
+
+	std::mt19937 random(0);
+	std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK);
+	std::chrono::steady_clock::duration readTime{};
+	std::size_t size = 0;
+	std::size_t reads = 0;
+	std::size_t readSize = 0;
+	std::size_t mismatches = 0;
+
+	for(auto& region : regions)
+	{
+		auto& chunks = region.chunks;
+
+		if(chunks.empty())
+			continue;
+
+		size += benchmarkRegion(region, scheme);
+
+		for(std::size_t i = 0; i != READS_PER_REGION; ++i)
+		{
+			auto index = std::uniform_int_distribution<std::size_t>(0, chunks.size() - 1)(random);
+
+			auto startTime = std::chrono::steady_clock::now();
+			scheme.readChunk(index, decoded.data());
+			readTime += std::chrono::steady_clock::now() - startTime;
+			++reads;
+			readSize += chunks[index].sectionCount * BLOCKS_PER_SECTION * sizeof *decoded.data();
+
+			auto out = decoded.data();
+
+			for(auto section : chunks[index].sections())
+			{
+				if(std::memcmp(section, out, sizeof *out * BLOCKS_PER_SECTION) != 0)
+				{
+					++mismatches;
+					break;
+				}
+
+				out += BLOCKS_PER_SECTION;
+			}
+		}
+	}
+
+	auto micros = std::chrono::duration_cast<std::chrono::nanoseconds>(readTime).count() / 1000.f;
+
+	std::printf("scheme: %s\n", scheme.name().c_str());
+	std::printf("size: %.2f MiB\n", size / 1024.f / 1024.f);
+	std::printf("random chunk read: %.1f us (%zu reads)\n", reads == 0 ? 0.f : micros / reads, reads);
+
+	if(mismatches == 0)
+		std::printf("roundtrip: ok\n");
+	else
+		std::printf("roundtrip: FAILED, %zu of %zu chunk reads differ from the source\n", mismatches, reads);
+
+	std::printf("\n");
+
+	BenchmarkResult result;
+	result.scheme = scheme.name();
+	result.inputSize = readSize;
+	result.size = size;
+	result.time = std::chrono::duration<float>(readTime).count();
+	return result;
+}
+
+inline
+void printLatencies(char const* label, LatencyHistogram const& histogram)
+{
+	std::printf("%s: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f us (%llu)\n", label,
+	            histogram.percentile(0.5) / 1000.f, histogram.percentile(0.9) / 1000.f, histogram.percentile(0.99) / 1000.f,
+	            histogram.percentile(0.999) / 1000.f, histogram.max() / 1000.f, (unsigned long long)histogram.count());
+}
+
+// records how long every section() call and every whole chunk, from beginChunk() to endChunk(), takes to encode
+// section latencies are broken down by the palette bit depth of the section, which is determined outside the timing
+template <typename Scheme>
+void benchmarkLatency(std::vector<Region> const& regions, Scheme scheme)
+{
+	using Clock = std::chrono::steady_clock;
+
+	LatencyHistogram chunkLatencies;
+	std::vector<LatencyHistogram> sectionLatencies(13);
+
+	for(auto& region : regions)
+	{
+		scheme.beginRegion(region);
+
+		for(auto& chunk : region.chunks)
+		{
+			std::uint8_t bits[SECTIONS_PER_CHUNK];
+
+			for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+				bits[i] = ceillog2(createPalette(chunk.firstSection[i], BLOCKS_PER_SECTION, true).size);
+
+			auto chunkStartTime = Clock::now();
+			scheme.beginChunk(chunk);
+
+			for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+			{
+				auto startTime = Clock::now();
+				scheme.section(chunk.firstSection[i]);
+				sectionLatencies[bits[i]].record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count());
+			}
+
+			scheme.endChunk();
+			chunkLatencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - chunkStartTime).count());
+		}
+
+		scheme.endRegion();
+	}
+
+	std::printf("scheme: %s\n", scheme.name().c_str());
+	printLatencies("chunk", chunkLatencies);
+
+	LatencyHistogram allSections;
+
+	for(auto& histogram : sectionLatencies)
+		allSections.merge(histogram);
+
+	printLatencies("section", allSections);
+
+	for(std::size_t bits = 0; bits != sectionLatencies.size(); ++bits)
+	{
+		if(sectionLatencies[bits].count() == 0)
+			continue;
+
+		auto label = "\t" + std::to_string(bits) + " bits";
+		printLatencies(label.c_str(), sectionLatencies[bits]);
+	}
+
+	std::printf("\n");
+}
@@ -1,10 +1,44 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 
+#include <immintrin.h>
+
+// generic version of the 64-bit word formats for widths above 8 bits, which only occur in sections with huge palettes
+template <int Bits>
+std::size_t bitpack16toWords(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	constexpr std::size_t valuesPerWord = 64 / Bits;
+
+	auto loopCount = count / valuesPerWord;
+	auto remainingCount = count % valuesPerWord;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		std::uint64_t next = 0;
+
+		for(std::size_t j = 0; j != valuesPerWord; ++j)
+			next |= (std::uint64_t)in[valuesPerWord * i + j] << (j * Bits);
+
+		std::memcpy(out + 8 * i, &next, sizeof next);
+	}
+
+	if(remainingCount == 0)
+		return loopCount * 8;
+
+	std::uint64_t final = 0;
+
+	for(std::size_t j = 0; j != remainingCount; ++j)
+		final |= (std::uint64_t)in[valuesPerWord * loopCount + j] << (j * Bits);
+
+	std::memcpy(out + 8 * loopCount, &final, sizeof final);
+	return loopCount * 8 + sizeof final;
+}
+
 inline
 std::size_t bitpack16to8(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
 {
@@ -49,7 +83,7 @@ std::size_t bitpack16to7(std::uint16_t const* in, std::size_t count, std::uint8_
 	std::uint64_t final = 0;
 
 	for(std::size_t i = 0; i != remainingCount; ++i)
-		final |= (std::uint64_t)in[i] << (i * 7);
+		final |= (std::uint64_t)in[loopCount * 9 + i] << (i * 7);
 
 	std::memcpy(out, &final, sizeof final);
 	return loopCount * 8 + sizeof final;
@@ -91,7 +125,7 @@ std::size_t bitpack16to6(std::uint16_t const* in, std::size_t count, std::uint8_
 	std::uint64_t final = 0;
 
 	for(std::size_t i = 0; i != remainingCount; ++i)
-		final |= (std::uint64_t)in[i] << (i * 6);
+		final |= (std::uint64_t)in[loopCount * 10 + i] << (i * 6);
 
 	std::memcpy(out, &final, sizeof final);
 	return loopCount * 8 + sizeof final;
@@ -135,7 +169,7 @@ std::size_t bitpack16to5(std::uint16_t const* in, std::size_t count, std::uint8_
 	std::uint64_t final = 0;
 
 	for(std::size_t i = 0; i != remainingCount; ++i)
-		final |= (std::uint64_t)in[i] << (i * 5);
+		final |= (std::uint64_t)in[loopCount * 12 + i] << (i * 5);
 
 	std::memcpy(out, &final, sizeof final);
 	return loopCount * 8 + sizeof final;
@@ -207,7 +241,7 @@ std::size_t bitpack16to3(std::uint16_t const* in, std::size_t count, std::uint8_
 	std::uint64_t final = 0;
 
 	for(std::size_t i = 0; i != remainingCount; ++i)
-		final |= (std::uint64_t)in[i] << (i * 3);
+		final |= (std::uint64_t)in[loopCount * 21 + i] << (i * 3);
 
 	std::memcpy(out, &final, sizeof final);
 	return loopCount * 8  + sizeof final;
@@ -253,6 +287,296 @@ std::size_t bitpack16to1(std::uint16_t const* in, std::size_t count, std::uint8_
 	return count;
 }
 
+inline
+bool bitpackVectorizedSupported()
+{
+	static bool const supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+	return supported;
+}
+
+// the vectorized kernels below are compiled for AVX2/BMI2 regardless of the global compiler flags,
+// callers must check bitpackVectorizedSupported() before using them
+
+// narrows 32 16-bit values that fit into 8 bits to 32 bytes, preserving their order
+__attribute__((target("avx2")))
+inline
+__m256i narrow16to8(std::uint16_t const* in)
+{
+	auto lo = _mm256_loadu_si256((__m256i const*)in);
+	auto hi = _mm256_loadu_si256((__m256i const*)(in + 16));
+	return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0b11'01'10'00);
+}
+
+// combines each pair of bytes into a single byte (lo * factor.lo + hi * factor.hi), 64 bytes in, 32 bytes out, order preserved
+__attribute__((target("avx2")))
+inline
+__m256i combineBytePairs(__m256i lo, __m256i hi, __m256i factors)
+{
+	lo = _mm256_maddubs_epi16(lo, factors);
+	hi = _mm256_maddubs_epi16(hi, factors);
+	return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0b11'01'10'00);
+}
+
+__attribute__((target("avx2")))
+inline
+std::size_t bitpack16to8Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	auto loopCount = count / 32;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+		_mm256_storeu_si256((__m256i*)(out + 32 * i), narrow16to8(in + 32 * i));
+
+	auto done = loopCount * 32;
+	return done + bitpack16to8(in + done, count - done, out + done);
+}
+
+__attribute__((target("avx2")))
+inline
+std::size_t bitpack16to4Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	// combine neighboring values with a multiply-add (lo + 16 * hi)
+
+	auto loopCount = count / 64;
+	auto factors = _mm256_set1_epi16(0x1001);
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		auto packed = combineBytePairs(narrow16to8(in + 64 * i), narrow16to8(in + 64 * i + 32), factors);
+		_mm256_storeu_si256((__m256i*)(out + 32 * i), packed);
+	}
+
+	auto done = loopCount * 64;
+	return loopCount * 32 + bitpack16to4(in + done, count - done, out + loopCount * 32);
+}
+
+__attribute__((target("avx2")))
+inline
+std::size_t bitpack16to1Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	// move each value into the sign bit of its byte and collect the sign bits
+
+	auto loopCount = count / 32;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		std::uint32_t bits = _mm256_movemask_epi8(_mm256_slli_epi16(narrow16to8(in + 32 * i), 7));
+		std::memcpy(out + 4 * i, &bits, sizeof bits);
+	}
+
+	auto done = loopCount * 32;
+	return loopCount * 4 + bitpack16to1(in + done, count - done, out + loopCount * 4);
+}
+
+// packs 64 / Bits consecutive bytes into a single 64-bit value, p must be readable for 8 bytes past the last value
+template <int Bits>
+__attribute__((target("bmi2")))
+std::uint64_t pextWord(std::uint8_t const* p)
+{
+	constexpr std::size_t valuesPerWord = 64 / Bits;
+	constexpr std::uint64_t byteMask = 0x0101'0101'0101'0101ull * ((1u << Bits) - 1);
+
+	std::uint64_t word = 0;
+
+	for(std::size_t j = 0; j < valuesPerWord; j += 8)
+	{
+		auto mask = valuesPerWord - j >= 8 ? byteMask : byteMask & ((1ull << 8 * (valuesPerWord - j)) - 1);
+
+		std::uint64_t bytes;
+		std::memcpy(&bytes, p + j, sizeof bytes);
+		word |= _pext_u64(bytes, mask) << (j * Bits);
+	}
+
+	return word;
+}
+
+// narrows 32 words worth of values to bytes, then gathers the bits of each word with pext
+// the trailing values that don't fill a whole batch are handed to the scalar kernel, which starts on a word boundary
+template <int Bits, typename ScalarKernel>
+__attribute__((target("avx2,bmi2")))
+std::size_t bitpackPextVectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out, ScalarKernel scalar)
+{
+	constexpr std::size_t valuesPerWord = 64 / Bits;
+	constexpr std::size_t wordsPerBatch = 32;
+	constexpr std::size_t valuesPerBatch = valuesPerWord * wordsPerBatch;
+
+	alignas(__m256i) std::uint8_t bytes[valuesPerBatch + 32];
+	auto loopCount = count / valuesPerBatch;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		auto batch = in + valuesPerBatch * i;
+
+		for(std::size_t j = 0; j != valuesPerBatch; j += 32)
+			_mm256_store_si256((__m256i*)(bytes + j), narrow16to8(batch + j));
+
+		for(std::size_t j = 0; j != wordsPerBatch; ++j)
+		{
+			auto word = pextWord<Bits>(bytes + valuesPerWord * j);
+			std::memcpy(out + 8 * (wordsPerBatch * i + j), &word, sizeof word);
+		}
+	}
+
+	auto done = loopCount * valuesPerBatch;
+	auto written = loopCount * wordsPerBatch * 8;
+	return written + scalar(in + done, count - done, out + written);
+}
+
+inline
+std::size_t bitpack16to7Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	return bitpackPextVectorized<7>(in, count, out, bitpack16to7);
+}
+
+inline
+std::size_t bitpack16to6Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	return bitpackPextVectorized<6>(in, count, out, bitpack16to6);
+}
+
+inline
+std::size_t bitpack16to5Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	return bitpackPextVectorized<5>(in, count, out, bitpack16to5);
+}
+
+inline
+std::size_t bitpack16to3Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	return bitpackPextVectorized<3>(in, count, out, bitpack16to3);
+}
+
+__attribute__((target("avx2")))
+inline
+std::size_t bitpack16to2Vectorized(std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	// same multiply-add trick as for 4 bits, applied twice: pairs of 2-bit values form 4-bit values, pairs of those form bytes
+
+	auto loopCount = count / 128;
+	auto pairFactors = _mm256_set1_epi16(0x0401);
+	auto nibbleFactors = _mm256_set1_epi16(0x1001);
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		auto block = in + 128 * i;
+		auto nibbles0 = combineBytePairs(narrow16to8(block), narrow16to8(block + 32), pairFactors);
+		auto nibbles1 = combineBytePairs(narrow16to8(block + 64), narrow16to8(block + 96), pairFactors);
+		_mm256_storeu_si256((__m256i*)(out + 32 * i), combineBytePairs(nibbles0, nibbles1, nibbleFactors));
+	}
+
+	auto done = loopCount * 128;
+	return loopCount * 32 + bitpack16to2(in + done, count - done, out + loopCount * 32);
+}
+
+// inverse of the 64-bit word formats used for widths that don't divide 8 (3, 5, 6, 7 and 9 to 12 bits)
+// each 64-bit value holds 64 / Bits values, the last one may be partially filled
+template <int Bits>
+std::size_t bitunpackWordsTo16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	constexpr std::size_t valuesPerWord = 64 / Bits;
+	constexpr std::uint64_t mask = (1 << Bits) - 1;
+
+	auto loopCount = count / valuesPerWord;
+	auto remainingCount = count % valuesPerWord;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		std::uint64_t next;
+		std::memcpy(&next, in + 8 * i, sizeof next);
+
+		for(std::size_t j = 0; j != valuesPerWord; ++j)
+			out[valuesPerWord * i + j] = (next >> (j * Bits)) & mask;
+	}
+
+	if(remainingCount == 0)
+		return loopCount * 8;
+
+	std::uint64_t final;
+	std::memcpy(&final, in + 8 * loopCount, sizeof final);
+
+	for(std::size_t j = 0; j != remainingCount; ++j)
+		out[valuesPerWord * loopCount + j] = (final >> (j * Bits)) & mask;
+
+	return loopCount * 8 + sizeof final;
+}
+
+inline
+std::size_t bitunpack8to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	for(std::size_t i = 0; i != count; ++i)
+		out[i] = in[i];
+
+	return count;
+}
+
+inline
+std::size_t bitunpack7to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	return bitunpackWordsTo16<7>(in, count, out);
+}
+
+inline
+std::size_t bitunpack6to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	return bitunpackWordsTo16<6>(in, count, out);
+}
+
+inline
+std::size_t bitunpack5to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	return bitunpackWordsTo16<5>(in, count, out);
+}
+
+inline
+std::size_t bitunpack4to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	assert(count % 2 == 0);
+	count /= 2;
+
+	for(std::size_t i = 0; i != count; ++i)
+	{
+		out[2 * i] = in[i] & 0xf;
+		out[2 * i + 1] = in[i] >> 4;
+	}
+
+	return count;
+}
+
+inline
+std::size_t bitunpack3to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	return bitunpackWordsTo16<3>(in, count, out);
+}
+
+inline
+std::size_t bitunpack2to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	assert(count % 4 == 0);
+	count /= 4;
+
+	for(std::size_t i = 0; i != count; ++i)
+	{
+		for(std::size_t j = 0; j != 4; ++j)
+			out[4 * i + j] = (in[i] >> (2 * j)) & 0b11;
+	}
+
+	return count;
+}
+
+inline
+std::size_t bitunpack1to16(std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	assert(count % 8 == 0);
+	count /= 8;
+
+	for(std::size_t i = 0; i != count; ++i)
+	{
+		for(std::size_t j = 0; j != 8; ++j)
+			out[8 * i + j] = (in[i] >> j) & 1;
+	}
+
+	return count;
+}
+
 inline
 int ceillog2(std::size_t x)
 {
@@ -261,8 +585,38 @@ int ceillog2(std::size_t x)
 }
 
 inline
-std::size_t bitpackVanilla(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+std::size_t bitpackVanillaVectorized(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	switch(ceillog2(distincts))
+	{
+	case 0: case 1: case 2: case 3: case 4:
+		return bitpack16to4Vectorized(in, count, out);
+
+	case 5: return bitpack16to5Vectorized(in, count, out);
+	case 6: return bitpack16to6Vectorized(in, count, out);
+	case 7: return bitpack16to7Vectorized(in, count, out);
+	case 8: return bitpack16to8Vectorized(in, count, out);
+
+	// there are no vectorized kernels for widths above 8 bits
+	case 9: return bitpack16toWords<9>(in, count, out);
+	case 10: return bitpack16toWords<10>(in, count, out);
+	case 11: return bitpack16toWords<11>(in, count, out);
+	case 12: return bitpack16toWords<12>(in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+inline
+std::size_t bitpackVanilla(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out, bool vectorize)
 {
+	if(vectorize && bitpackVectorizedSupported())
+		return bitpackVanillaVectorized(distincts, in, count, out);
+
 	switch(ceillog2(distincts))
 	{
 	case 0: case 1: case 2: case 3: case 4:
@@ -272,23 +626,61 @@ std::size_t bitpackVanilla(std::size_t distincts, std::uint16_t const* in, std::
 	case 6: return bitpack16to6(in, count, out);
 	case 7: return bitpack16to7(in, count, out);
 	case 8: return bitpack16to8(in, count, out);
+	case 9: return bitpack16toWords<9>(in, count, out);
+	case 10: return bitpack16toWords<10>(in, count, out);
+	case 11: return bitpack16toWords<11>(in, count, out);
+	case 12: return bitpack16toWords<12>(in, count, out);
 
 	default: break;
 	}
 
-	// this should not happen with test data
+	// palettes never have more than 4096 entries, which take 12 bits
 	assert(false);
 	__builtin_unreachable();
 }
 
 inline
-std::size_t bitpackOptimized(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+std::size_t bitpackOptimizedVectorized(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
 {
 	switch(ceillog2(distincts))
 	{
 	// if there is only a single distinct value, we don't need to store anything
 	case 0: return 0;
 
+	case 1: return bitpack16to1Vectorized(in, count, out);
+	case 2: return bitpack16to2Vectorized(in, count, out);
+	case 3: return bitpack16to3Vectorized(in, count, out);
+	case 4: return bitpack16to4Vectorized(in, count, out);
+	case 5: return bitpack16to5Vectorized(in, count, out);
+	case 6: return bitpack16to6Vectorized(in, count, out);
+	case 7: return bitpack16to7Vectorized(in, count, out);
+	case 8: return bitpack16to8Vectorized(in, count, out);
+
+	// there are no vectorized kernels for widths above 8 bits
+	case 9: return bitpack16toWords<9>(in, count, out);
+	case 10: return bitpack16toWords<10>(in, count, out);
+	case 11: return bitpack16toWords<11>(in, count, out);
+	case 12: return bitpack16toWords<12>(in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+inline
+std::size_t bitpackOptimized(std::size_t distincts, std::uint16_t const* in, std::size_t count, std::uint8_t* out, bool vectorize)
+{
+	if(vectorize && bitpackVectorizedSupported())
+		return bitpackOptimizedVectorized(distincts, in, count, out);
+
+	switch(ceillog2(distincts))
+	{
+	// if there is only a single distinct value, we don't need to store anything
+	case 0: return 0;
+
 	case 1: return bitpack16to1(in, count, out);
 	case 2: return bitpack16to2(in, count, out);
 	case 3: return bitpack16to3(in, count, out);
@@ -297,11 +689,71 @@ std::size_t bitpackOptimized(std::size_t distincts, std::uint16_t const* in, std
 	case 6: return bitpack16to6(in, count, out);
 	case 7: return bitpack16to7(in, count, out);
 	case 8: return bitpack16to8(in, count, out);
+	case 9: return bitpack16toWords<9>(in, count, out);
+	case 10: return bitpack16toWords<10>(in, count, out);
+	case 11: return bitpack16toWords<11>(in, count, out);
+	case 12: return bitpack16toWords<12>(in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+inline
+std::size_t bitunpackVanilla(std::size_t distincts, std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	switch(ceillog2(distincts))
+	{
+	case 0: case 1: case 2: case 3: case 4:
+		return bitunpack4to16(in, count, out);
+
+	case 5: return bitunpack5to16(in, count, out);
+	case 6: return bitunpack6to16(in, count, out);
+	case 7: return bitunpack7to16(in, count, out);
+	case 8: return bitunpack8to16(in, count, out);
+	case 9: return bitunpackWordsTo16<9>(in, count, out);
+	case 10: return bitunpackWordsTo16<10>(in, count, out);
+	case 11: return bitunpackWordsTo16<11>(in, count, out);
+	case 12: return bitunpackWordsTo16<12>(in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+inline
+std::size_t bitunpackOptimized(std::size_t distincts, std::uint8_t const* in, std::size_t count, std::uint16_t* out)
+{
+	switch(ceillog2(distincts))
+	{
+	// a single distinct value is not stored, every index is 0
+	case 0:
+		std::fill(out, out + count, 0);
+		return 0;
+
+	case 1: return bitunpack1to16(in, count, out);
+	case 2: return bitunpack2to16(in, count, out);
+	case 3: return bitunpack3to16(in, count, out);
+	case 4: return bitunpack4to16(in, count, out);
+	case 5: return bitunpack5to16(in, count, out);
+	case 6: return bitunpack6to16(in, count, out);
+	case 7: return bitunpack7to16(in, count, out);
+	case 8: return bitunpack8to16(in, count, out);
+	case 9: return bitunpackWordsTo16<9>(in, count, out);
+	case 10: return bitunpackWordsTo16<10>(in, count, out);
+	case 11: return bitunpackWordsTo16<11>(in, count, out);
+	case 12: return bitunpackWordsTo16<12>(in, count, out);
 
 	default: break;
 	}
 
-	// this should not happen with test data
+	// palettes never have more than 4096 entries, which take 12 bits
 	assert(false);
 	__builtin_unreachable();
 }
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "parser.hpp"
+
+// the order the blocks of a section are packed in
+// sections are stored with x varying fastest, then z, then y, so blocks that are neighbours along z or y end up 16
+// or 256 positions apart, space filling curves keep most neighbours close in every direction
+enum class BlockOrder
+{
+	linear,
+	// bits of x, z and y interleaved, the curve jumps at the borders of every power of two sized cube
+	morton,
+	// every block follows a neighbour of the previous one
+	hilbert,
+};
+
+inline
+char const* blockOrderName(BlockOrder order)
+{
+	switch(order)
+	{
+	case BlockOrder::linear: return "linear";
+	case BlockOrder::morton: return "morton";
+	case BlockOrder::hilbert: return "hilbert";
+	}
+
+	return "";
+}
+
+// suffix of the names of schemes using the given order, empty for the default
+inline
+std::string blockOrderSuffix(BlockOrder order)
+{
+	return order == BlockOrder::linear ? "" : std::string("-") + blockOrderName(order);
+}
+
+inline
+std::uint16_t sectionIndex(unsigned x, unsigned y, unsigned z)
+{
+	return y << 8 | z << 4 | x;
+}
+
+// storage index of the block at every position of the curve
+using BlockOrderTable = std::array<std::uint16_t, BLOCKS_PER_SECTION>;
+
+inline
+BlockOrderTable makeMortonTable()
+{
+	BlockOrderTable table;
+
+	for(unsigned i = 0; i != BLOCKS_PER_SECTION; ++i)
+	{
+		unsigned coordinates[3] = {};
+
+		for(unsigned bit = 0; bit != 4; ++bit)
+			for(unsigned axis = 0; axis != 3; ++axis)
+				coordinates[axis] |= (i >> (3 * bit + axis) & 1) << bit;
+
+		table[i] = sectionIndex(coordinates[0], coordinates[2], coordinates[1]);
+	}
+
+	return table;
+}
+
+// the 3d hilbert curve of 16 blocks per side, with Skilling's conversion from the transposed curve index to
+// coordinates
+inline
+BlockOrderTable makeHilbertTable()
+{
+	BlockOrderTable table;
+
+	for(unsigned i = 0; i != BLOCKS_PER_SECTION; ++i)
+	{
+		// the transposed index: every third bit of the curve index, starting from the highest one, belongs to an axis
+		unsigned axes[3] = {};
+
+		for(unsigned bit = 0; bit != 4; ++bit)
+			for(unsigned axis = 0; axis != 3; ++axis)
+				axes[axis] |= (i >> (3 * bit + 2 - axis) & 1) << bit;
+
+		// gray decode
+		auto t = axes[2] >> 1;
+
+		for(unsigned axis = 2; axis != 0; --axis)
+			axes[axis] ^= axes[axis - 1];
+
+		axes[0] ^= t;
+
+		// undo the rotations and reflections of the subcubes
+		for(unsigned q = 2; q != 16; q <<= 1)
+		{
+			auto p = q - 1;
+
+			for(int axis = 2; axis >= 0; --axis)
+			{
+				if(axes[axis] & q)
+					axes[0] ^= p;
+				else
+				{
+					t = (axes[0] ^ axes[axis]) & p;
+					axes[0] ^= t;
+					axes[axis] ^= t;
+				}
+			}
+		}
+
+		table[i] = sectionIndex(axes[2], axes[0], axes[1]);
+	}
+
+	return table;
+}
+
+// the tables are built once, after that reordering a section is a single gather or scatter of 4096 blocks
+inline
+std::uint16_t const* blockOrderTable(BlockOrder order)
+{
+	static BlockOrderTable const morton = makeMortonTable();
+	static BlockOrderTable const hilbert = makeHilbertTable();
+
+	return order == BlockOrder::morton ? morton.data() : hilbert.data();
+}
+
+// the blocks of a section in the given order, which is either data itself or buffer holding the reordered blocks
+inline
+std::uint16_t const* reorderBlocks(std::uint16_t const* data, BlockOrder order, std::uint16_t* buffer)
+{
+	if(order == BlockOrder::linear)
+		return data;
+
+	auto table = blockOrderTable(order);
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+		buffer[i] = data[table[i]];
+
+	return buffer;
+}
+
+// inverse of reorderBlocks, writes the blocks of a section in the given order to out in storage order
+inline
+void restoreBlocks(std::uint16_t const* in, BlockOrder order, std::uint16_t* out)
+{
+	if(order == BlockOrder::linear)
+	{
+		std::copy(in, in + BLOCKS_PER_SECTION, out);
+		return;
+	}
+
+	auto table = blockOrderTable(order);
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+		out[table[i]] = in[i];
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "palettepack.hpp"
+#include "parser.hpp"
+#include "threadpool.hpp"
+
+// the encoded sections of every chunk in one contiguous arena, which is exactly what Opt2CompressionScheme hands to
+// its compressor, so a sweep over compressors only needs to palettize and pack the world once
+class ChunkCache
+{
+	std::vector<std::uint8_t> _data;
+	// chunk i occupies [_offsets[i], _offsets[i + 1])
+	std::vector<std::size_t> _offsets{0};
+	std::vector<std::uint8_t> _sectionCounts;
+	std::size_t _sectionCount = 0;
+
+public:
+	std::size_t chunkCount() const
+	{
+		return _offsets.size() - 1;
+	}
+
+	std::uint8_t const* chunk(std::size_t i) const
+	{
+		return _data.data() + _offsets[i];
+	}
+
+	std::size_t chunkSize(std::size_t i) const
+	{
+		return _offsets[i + 1] - _offsets[i];
+	}
+
+	// all payloads back to back
+	std::uint8_t const* data() const
+	{
+		return _data.data();
+	}
+
+	// total size of all payloads
+	std::size_t size() const
+	{
+		return _data.size();
+	}
+
+	// number of sections encoded in chunk i
+	std::size_t sectionCount(std::size_t i) const
+	{
+		return _sectionCounts[i];
+	}
+
+	// size of the raw sections the payloads were encoded from
+	std::size_t inputSize() const
+	{
+		return _sectionCount * BLOCKS_PER_SECTION * sizeof(std::uint16_t);
+	}
+
+	void append(ChunkCache const& other)
+	{
+		for(std::size_t i = 0; i != other.chunkCount(); ++i)
+			append(other.chunk(i), other.chunkSize(i), other.sectionCount(i));
+	}
+
+	void append(Chunk const& chunk, PaletteOrder order = PaletteOrder::firstSeen, BlockOrder blockOrder = BlockOrder::linear)
+	{
+		auto offset = _data.size();
+		_data.resize(offset + MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK);
+
+		std::size_t size = 0;
+		std::size_t sectionCount = 0;
+
+		for(auto section : chunk.sections())
+		{
+			size += encodeSection(section, _data.data() + offset + size, order, blockOrder);
+			++sectionCount;
+		}
+
+		_data.resize(offset + size);
+		_offsets.push_back(_data.size());
+		_sectionCounts.push_back(sectionCount);
+		_sectionCount += sectionCount;
+	}
+
+	// the first chunkCount chunks, cheap enough to time configurations on before a sweep
+	ChunkCache prefix(std::size_t chunkCount) const
+	{
+		ChunkCache result;
+
+		for(std::size_t i = 0; i != std::min(chunkCount, this->chunkCount()); ++i)
+			result.append(chunk(i), chunkSize(i), sectionCount(i));
+
+		return result;
+	}
+
+private:
+	void append(std::uint8_t const* payload, std::size_t size, std::size_t sectionCount)
+	{
+		_data.insert(_data.end(), payload, payload + size);
+		_offsets.push_back(_data.size());
+		_sectionCounts.push_back(sectionCount);
+		_sectionCount += sectionCount;
+	}
+};
+
+// encodes the regions on the given number of threads, the chunks end up in the same order as in the regions
+inline
+ChunkCache buildChunkCache(std::vector<Region> const& regions, std::size_t threads, PaletteOrder order = PaletteOrder::firstSeen,
+                           BlockOrder blockOrder = BlockOrder::linear)
+{
+	std::vector<ChunkCache> regionCaches(regions.size());
+	WorkStealingRange range(threads, regions.size());
+
+	runWorkers(threads, [&](std::size_t worker)
+	{
+		std::size_t item;
+
+		while(range.next(worker, item))
+		{
+			for(auto& chunk : regions[item].chunks)
+				regionCaches[item].append(chunk, order, blockOrder);
+		}
+	});
+
+	ChunkCache cache;
+
+	for(auto& regionCache : regionCaches)
+		cache.append(regionCache);
+
+	return cache;
+}
@@ -0,0 +1,79 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "results.hpp"
+
+using Record = std::map<std::string, std::string>;
+
+std::string recordKey(Record const& record)
+{
+	return record.at("name") + " (" + record.at("mode") + ", " + record.at("threads") + " threads)";
+}
+
+int main(int argc, char** argv)
+{
+	auto args = std::vector(argv, argv + argc);
+
+	if(args.size() != 3 && !(args.size() == 5 && args[3] == std::string("--threshold")))
+		fatalError("invalid args, expected %s <baseline> <candidate> [--threshold <percent>]\n", args[0]);
+
+	// speeds usually vary by a few percent between runs on the same machine
+	auto threshold = args.size() == 5 ? std::strtod(args[4], nullptr) : 5.;
+
+	auto baseline = readResults(args[1]);
+	auto candidate = readResults(args[2]);
+
+	if(!baseline.empty() && !candidate.empty())
+	{
+		for(auto key : {"cpu", "compiler", "flags", "host"})
+		{
+			if(baseline[0][key] != candidate[0][key])
+				std::printf("%s differs: '%s' vs '%s'\n", key, baseline[0][key].c_str(), candidate[0][key].c_str());
+		}
+
+		std::printf("\n");
+	}
+
+	std::map<std::string, Record const*> baselineRecords;
+
+	for(auto& record : baseline)
+		baselineRecords[recordKey(record)] = &record;
+
+	std::size_t regressions = 0;
+
+	for(auto& record : candidate)
+	{
+		auto key = recordKey(record);
+		auto it = baselineRecords.find(key);
+
+		if(it == baselineRecords.end())
+		{
+			std::printf("%s: only in candidate\n", key.c_str());
+			continue;
+		}
+
+		auto& base = *it->second;
+		baselineRecords.erase(it);
+
+		auto ratioChange = relativeChange(resultNumber(base, "ratio"), resultNumber(record, "ratio"));
+		auto speedChange = relativeChange(resultNumber(base, "mib_per_second"), resultNumber(record, "mib_per_second"));
+		auto regressed = isRegression(base, record, threshold);
+
+		std::printf("%s: ratio %.2f -> %.2f (%+.1f%%), speed %.2f -> %.2f MiB/s (%+.1f%%)%s\n", key.c_str(),
+		            resultNumber(base, "ratio"), resultNumber(record, "ratio"), ratioChange,
+		            resultNumber(base, "mib_per_second"), resultNumber(record, "mib_per_second"), speedChange,
+		            regressed ? "  REGRESSION" : "");
+
+		regressions += regressed;
+	}
+
+	for(auto& [key, record] : baselineRecords)
+		std::printf("%s: only in baseline\n", key.c_str());
+
+	std::printf("\n%zu regressions beyond %.1f%%\n", regressions, threshold);
+	return regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,14 +1,53 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <string>
 
+#include <brotli/decode.h>
 #include <brotli/encode.h>
 
+#include "context.hpp"
+
+// brotli has no way to reset a decoder, a new one is created for every call, from memory that is kept between calls
+class BrotliDecompressor
+{
+	ContextArena _arena;
+
+public:
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		ContextPointer<BrotliDecoderState, BrotliDecoderDestroyInstance> decoder(
+			BrotliDecoderCreateInstance(ContextArena::allocate, ContextArena::release, &_arena));
+
+		auto nextIn = (std::uint8_t const*)in;
+		auto nextOut = (std::uint8_t*)out;
+		auto availableIn = inSize;
+		auto availableOut = outSize;
+
+		auto result = decoder ? BrotliDecoderDecompressStream(decoder.get(), &availableIn, &nextIn, &availableOut, &nextOut, nullptr)
+		                      : BROTLI_DECODER_RESULT_ERROR;
+
+		decoder.reset();
+		_arena.reset();
+
+		if(result != BROTLI_DECODER_RESULT_SUCCESS)
+		{
+			std::fprintf(stderr, "brotli decompressor: decompression failed\n");
+			std::terminate();
+		}
+
+		return outSize - availableOut;
+	}
+};
+
+// the same as BrotliEncoderCompress, except that the encoder is created from memory that is kept between calls, since
+// brotli has no way to reset one either
 class BrotliCompressor
 {
+	ContextArena _arena;
 	int _level;
 
 public:
@@ -21,14 +60,37 @@ public:
 		return "brotli/" + std::to_string(_level);
 	}
 
+	BrotliDecompressor decompressor() const
+	{
+		return BrotliDecompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		if(!BrotliEncoderCompress(_level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, inSize, (unsigned char const*)in, &outSize, (unsigned char*)out))
+		ContextPointer<BrotliEncoderState, BrotliEncoderDestroyInstance> encoder(
+			BrotliEncoderCreateInstance(ContextArena::allocate, ContextArena::release, &_arena));
+
+		auto nextIn = (std::uint8_t const*)in;
+		auto nextOut = (std::uint8_t*)out;
+		auto availableIn = inSize;
+		auto availableOut = outSize;
+
+		auto success = encoder
+		               && BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_QUALITY, _level)
+		               && BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_LGWIN, BROTLI_DEFAULT_WINDOW)
+		               && BrotliEncoderSetParameter(encoder.get(), BROTLI_PARAM_SIZE_HINT, inSize)
+		               && BrotliEncoderCompressStream(encoder.get(), BROTLI_OPERATION_FINISH, &availableIn, &nextIn, &availableOut, &nextOut, nullptr)
+		               && BrotliEncoderIsFinished(encoder.get());
+
+		encoder.reset();
+		_arena.reset();
+
+		if(!success)
 		{
 			std::fprintf(stderr, "brotli compressor: compression failed\n");
 			std::terminate();
 		}
 
-		return outSize;
+		return outSize - availableOut;
 	}
 };
@@ -1,12 +1,60 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
+#include <exception>
 #include <string>
 
 #include <bzlib.h>
 
+#include "context.hpp"
+
+// bzip2 can't reset its state, so the stream is set up for every call with memory that is kept between calls
+inline
+bz_stream bzip2Stream(ContextArena& arena, void const* in, std::size_t inSize, void* out, std::size_t outSize)
+{
+	bz_stream stream = {};
+	stream.next_in = (char*)in;
+	stream.avail_in = inSize;
+	stream.next_out = (char*)out;
+	stream.avail_out = outSize;
+	stream.bzalloc = [](void* opaque, int count, int size) { return ContextArena::allocate(opaque, (std::size_t)count * size); };
+	stream.bzfree = ContextArena::release;
+	stream.opaque = &arena;
+	return stream;
+}
+
+class Bzip2Decompressor
+{
+	ContextArena _arena;
+
+public:
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		auto stream = bzip2Stream(_arena, in, inSize, out, outSize);
+		auto success = BZ2_bzDecompressInit(&stream, 0, 0) == BZ_OK;
+
+		if(success)
+		{
+			success = BZ2_bzDecompress(&stream) == BZ_STREAM_END;
+			BZ2_bzDecompressEnd(&stream);
+		}
+
+		_arena.reset();
+
+		if(!success)
+		{
+			std::fprintf(stderr, "bzip2 decompression failed\n");
+			std::terminate();
+		}
+
+		return outSize - stream.avail_out;
+	}
+};
+
 class Bzip2Compressor
 {
+	ContextArena _arena;
 	int _level;
 
 public:
@@ -19,16 +67,30 @@ public:
 		return "bzip2/" + std::to_string(_level);
 	}
 
+	Bzip2Decompressor decompressor() const
+	{
+		return Bzip2Decompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		unsigned outSize2 = outSize;
+		auto stream = bzip2Stream(_arena, in, inSize, out, outSize);
+		auto success = BZ2_bzCompressInit(&stream, 9, 0, _level) == BZ_OK;
+
+		if(success)
+		{
+			success = BZ2_bzCompress(&stream, BZ_FINISH) == BZ_STREAM_END;
+			BZ2_bzCompressEnd(&stream);
+		}
+
+		_arena.reset();
 
-		if(BZ2_bzBuffToBuffCompress((char*)out, &outSize2, (char*)in, inSize, 9, 0, _level) != BZ_OK)
+		if(!success)
 		{
 			std::fprintf(stderr, "bzip2 compression failed\n");
 			std::terminate();
 		}
 
-		return outSize2;
+		return outSize - stream.avail_out;
 	}
 };
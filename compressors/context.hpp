@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// frees a library context with the given function, so a std::unique_ptr can own it
+template <auto Free>
+struct ContextDeleter
+{
+	template <typename T>
+	void operator()(T* context) const
+	{
+		Free(context);
+	}
+};
+
+template <typename T, auto Free>
+using ContextPointer = std::unique_ptr<T, ContextDeleter<Free>>;
+
+// memory for libraries that can't reset their state and create it anew for every call, handed out from one block
+// that is kept between calls
+// nothing is freed before reset(), which makes the block large enough for everything a whole call allocates, so
+// after the first call there are no more allocations
+class ContextArena
+{
+	static constexpr std::size_t ALIGNMENT = 16;
+
+	std::unique_ptr<std::uint8_t[]> _block;
+	std::size_t _capacity = 0;
+	std::size_t _used = 0;
+	// allocations that didn't fit into the block, until the next reset() grows it
+	std::vector<std::unique_ptr<std::uint8_t[]>> _overflow;
+
+public:
+	void* allocate(std::size_t size)
+	{
+		size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		_used += size;
+
+		if(_used <= _capacity)
+			return _block.get() + _used - size;
+
+		_overflow.emplace_back(new std::uint8_t[size]);
+		return _overflow.back().get();
+	}
+
+	// releases everything allocated since the last reset
+	void reset()
+	{
+		if(!_overflow.empty())
+		{
+			_overflow.clear();
+			_block.reset(new std::uint8_t[_used]);
+			_capacity = _used;
+		}
+
+		_used = 0;
+	}
+
+	// callbacks for the allocation interfaces of C libraries, with the arena as their opaque pointer
+	static void* allocate(void* arena, std::size_t size)
+	{
+		return static_cast<ContextArena*>(arena)->allocate(size);
+	}
+
+	static void release(void*, void*)
+	{
+	}
+};
@@ -1,13 +1,40 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
+#include <exception>
 #include <string>
 
 #include <libdeflate.h>
 
+#include "context.hpp"
+
+class LibDeflateDecompressor
+{
+	ContextPointer<libdeflate_decompressor, libdeflate_free_decompressor> _decompressor;
+
+public:
+	LibDeflateDecompressor()
+	: _decompressor(libdeflate_alloc_decompressor())
+	{}
+
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		std::size_t actualOutSize;
+
+		if(libdeflate_zlib_decompress(_decompressor.get(), in, inSize, out, outSize, &actualOutSize) != LIBDEFLATE_SUCCESS)
+		{
+			std::fprintf(stderr, "libdeflate decompression failed\n");
+			std::terminate();
+		}
+
+		return actualOutSize;
+	}
+};
+
 class LibDeflateCompressor
 {
-	libdeflate_compressor* _compressor;
+	ContextPointer<libdeflate_compressor, libdeflate_free_compressor> _compressor;
 	int _level;
 
 public:
@@ -21,8 +48,13 @@ public:
 		return "libdeflate/" + std::to_string(_level);
 	}
 
+	LibDeflateDecompressor decompressor() const
+	{
+		return LibDeflateDecompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		return libdeflate_zlib_compress(_compressor, in, inSize, out, outSize);
+		return libdeflate_zlib_compress(_compressor.get(), in, inSize, out, outSize);
 	}
 };
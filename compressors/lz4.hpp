@@ -1,17 +1,41 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <memory>
 #include <string>
 
 #include <lz4.h>
 
+class Lz4Decompressor
+{
+public:
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		auto size = LZ4_decompress_safe((char const*)in, (char*)out, inSize, outSize);
+
+		if(size < 0)
+		{
+			std::fprintf(stderr, "lz4 decompression failed\n");
+			std::terminate();
+		}
+
+		return size;
+	}
+};
+
+// compresses with a state of its own, which LZ4_compress_fast would otherwise set up on the stack or, in builds
+// with LZ4_HEAPMODE, allocate for every call
 class Lz4Compressor
 {
+	std::unique_ptr<char[]> _state;
 	int _level;
 
 public:
 	explicit Lz4Compressor(int level)
-		: _level(level)
+	: _state(new char[LZ4_sizeofState()])
+	, _level(level)
 	{}
 
 	std::string name() const
@@ -19,9 +43,14 @@ public:
 		return "lz4/" + std::to_string(_level);
 	}
 
+	Lz4Decompressor decompressor() const
+	{
+		return Lz4Decompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		auto size = LZ4_compress_fast((char const*)in, (char*)out, inSize, outSize, _level);
+		auto size = LZ4_compress_fast_extState(_state.get(), (char const*)in, (char*)out, inSize, outSize, _level);
 
 		if(size == 0)
 		{
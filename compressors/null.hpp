@@ -1,8 +1,25 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <exception>
+#include <string>
+
+struct NullDecompressor
+{
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		if(outSize < inSize)
+		{
+			std::fprintf(stderr, "null decompressor: not enough buffer space\n");
+			std::terminate();
+		}
+
+		std::memcpy(out, in, inSize);
+		return inSize;
+	}
+};
 
 struct NullCompressor
 {
@@ -11,6 +28,11 @@ struct NullCompressor
 		return "null";
 	}
 
+	NullDecompressor decompressor() const
+	{
+		return NullDecompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
 		if(outSize < inSize)
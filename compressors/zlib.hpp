@@ -3,34 +3,105 @@
 #include <cstddef>
 #include <cstdio>
 #include <exception>
+#include <memory>
 #include <string>
 
 #include <zlib.h>
 
+// z_streams are referenced from their internal state, so they live on the heap where moves don't touch them
+template <int (*End)(z_streamp)>
+struct ZlibStreamDeleter
+{
+	void operator()(z_stream* stream) const
+	{
+		End(stream);
+		delete stream;
+	}
+};
+
+template <int (*End)(z_streamp)>
+using ZlibStream = std::unique_ptr<z_stream, ZlibStreamDeleter<End>>;
+
+// inflates whole zlib streams, resetting one inflate state instead of allocating a new one for every call
+class ZlibDecompressor
+{
+	ZlibStream<inflateEnd> _stream;
+
+public:
+	ZlibDecompressor()
+	: _stream(new z_stream())
+	{
+		if(inflateInit(_stream.get()) != Z_OK)
+		{
+			std::fprintf(stderr, "zlib: decompressor initialization failure\n");
+			std::terminate();
+		}
+	}
+
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		auto stream = _stream.get();
+		inflateReset(stream);
+
+		stream->next_in = (unsigned char*)in;
+		stream->avail_in = inSize;
+		stream->next_out = (unsigned char*)out;
+		stream->avail_out = outSize;
+
+		if(inflate(stream, Z_FINISH) != Z_STREAM_END)
+		{
+			std::fprintf(stderr, "zlib: decompression failure\n");
+			std::terminate();
+		}
+
+		return stream->total_out;
+	}
+};
+
+// produces the same streams as compress2, resetting one deflate state instead of allocating a new one for every call
 class ZlibCompressor
 {
+	ZlibStream<deflateEnd> _stream;
 	int _level;
 
 public:
 	explicit ZlibCompressor(int level)
-	: _level(level)
-	{}
+	: _stream(new z_stream())
+	, _level(level)
+	{
+		if(deflateInit(_stream.get(), level) != Z_OK)
+		{
+			std::fprintf(stderr, "zlib: compressor initialization failure\n");
+			std::terminate();
+		}
+	}
 
 	std::string name() const
 	{
 		return "zlib/" + std::to_string(_level);
 	}
 
+	ZlibDecompressor decompressor() const
+	{
+		return ZlibDecompressor();
+	}
+
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		auto code = compress2((unsigned char*)out, &outSize, (unsigned char const*)in, inSize, _level);
+		auto stream = _stream.get();
+		deflateReset(stream);
+
+		stream->next_in = (unsigned char*)in;
+		stream->avail_in = inSize;
+		stream->next_out = (unsigned char*)out;
+		stream->avail_out = outSize;
 
-		if(code != Z_OK)
+		if(deflate(stream, Z_FINISH) != Z_STREAM_END)
 		{
 			std::fprintf(stderr, "zlib: compression failure\n");
 			std::terminate();
 		}
 
-		return outSize;
+		return stream->total_out;
 	}
 };
@@ -1,13 +1,40 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
+#include <exception>
 #include <string>
 
 #include <zstd.h>
 
+#include "context.hpp"
+
+class ZstdDecompressor
+{
+	ContextPointer<ZSTD_DCtx, ZSTD_freeDCtx> _ctx;
+
+public:
+	ZstdDecompressor()
+	: _ctx(ZSTD_createDCtx())
+	{}
+
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		auto size = ZSTD_decompressDCtx(_ctx.get(), out, outSize, in, inSize);
+
+		if(ZSTD_isError(size))
+		{
+			std::fprintf(stderr, "zstd decompression failed: %s\n", ZSTD_getErrorName(size));
+			std::terminate();
+		}
+
+		return size;
+	}
+};
+
 class ZstdCompressor
 {
-	ZSTD_CCtx* _ctx;
+	ContextPointer<ZSTD_CCtx, ZSTD_freeCCtx> _ctx;
 	int _level;
 
 public:
@@ -16,18 +43,18 @@ public:
 	, _level(level)
 	{}
 
-	~ZstdCompressor()
+	std::string name() const
 	{
-		ZSTD_freeCCtx(_ctx);
+		return "zstd/" + std::to_string(_level);
 	}
 
-	std::string name() const
+	ZstdDecompressor decompressor() const
 	{
-		return "zstd/" + std::to_string(_level);
+		return ZstdDecompressor();
 	}
 
 	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
 	{
-		return ZSTD_compressCCtx(_ctx, out, outSize, in, inSize, _level);
+		return ZSTD_compressCCtx(_ctx.get(), out, outSize, in, inSize, _level);
 	}
 };
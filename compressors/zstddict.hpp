@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include "context.hpp"
+
+// zdict's default capacity, a good fit for samples of a few KiB each
+constexpr std::size_t ZSTD_DICTIONARY_SIZE = 110 * 1024;
+
+using ZstdDictionary = std::shared_ptr<std::vector<std::uint8_t> const>;
+
+// trains a dictionary on the concatenated samples, sampleSizes holds the size of each of them
+// returns null if zdict can't train one, e.g. on less input than the capacity
+inline
+ZstdDictionary trainZstdDictionary(void const* samples, std::vector<std::size_t> const& sampleSizes, std::size_t capacity = ZSTD_DICTIONARY_SIZE)
+{
+	std::vector<std::uint8_t> dictionary(capacity);
+	auto size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples, sampleSizes.data(), sampleSizes.size());
+
+	if(ZDICT_isError(size))
+	{
+		std::fprintf(stderr, "zstd dictionary training failed: %s\n", ZDICT_getErrorName(size));
+		return nullptr;
+	}
+
+	dictionary.resize(size);
+	return std::make_shared<std::vector<std::uint8_t> const>(std::move(dictionary));
+}
+
+class ZstdDictDecompressor
+{
+	ContextPointer<ZSTD_DCtx, ZSTD_freeDCtx> _ctx;
+	ContextPointer<ZSTD_DDict, ZSTD_freeDDict> _dictionary;
+
+public:
+	explicit ZstdDictDecompressor(ZstdDictionary const& dictionary)
+	: _ctx(ZSTD_createDCtx())
+	, _dictionary(ZSTD_createDDict(dictionary->data(), dictionary->size()))
+	{}
+
+	std::size_t decompress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		auto size = ZSTD_decompress_usingDDict(_ctx.get(), out, outSize, in, inSize, _dictionary.get());
+
+		if(ZSTD_isError(size))
+		{
+			std::fprintf(stderr, "zstd decompression failed: %s\n", ZSTD_getErrorName(size));
+			std::terminate();
+		}
+
+		return size;
+	}
+};
+
+// zstd with a pre-trained dictionary, digested once into a CDict so compressing a chunk doesn't reload it
+class ZstdDictCompressor
+{
+	ContextPointer<ZSTD_CCtx, ZSTD_freeCCtx> _ctx;
+	ContextPointer<ZSTD_CDict, ZSTD_freeCDict> _cdict;
+	ZstdDictionary _dictionary;
+	int _level;
+
+public:
+	ZstdDictCompressor(int level, ZstdDictionary dictionary)
+	: _ctx(ZSTD_createCCtx())
+	, _cdict(ZSTD_createCDict(dictionary->data(), dictionary->size(), level))
+	, _dictionary(std::move(dictionary))
+	, _level(level)
+	{}
+
+	std::string name() const
+	{
+		return "zstd-dict/" + std::to_string(_level);
+	}
+
+	ZstdDictDecompressor decompressor() const
+	{
+		return ZstdDictDecompressor(_dictionary);
+	}
+
+	std::size_t compress(void const* in, std::size_t inSize, void* out, std::size_t outSize)
+	{
+		return ZSTD_compress_usingCDict(_ctx.get(), out, outSize, in, inSize, _cdict.get());
+	}
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// log-linear histogram in the style of HdrHistogram: values are grouped by their highest set bit and each power of
+// two range is split into 2^SUB_BUCKET_BITS linear buckets, so every recorded value is reproduced within 1/32
+// recording is a handful of instructions and the memory use is fixed, no matter how many values go in
+class LatencyHistogram
+{
+	static constexpr int SUB_BUCKET_BITS = 5;
+	static constexpr std::uint64_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+	std::vector<std::uint64_t> _counts;
+	std::uint64_t _count = 0;
+	std::uint64_t _max = 0;
+
+	static std::size_t bucketIndex(std::uint64_t value)
+	{
+		if(value < SUB_BUCKET_COUNT)
+			return value;
+
+		auto shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+		return (shift + 1) * SUB_BUCKET_COUNT + ((value >> shift) & (SUB_BUCKET_COUNT - 1));
+	}
+
+	// the largest value that falls into the bucket
+	static std::uint64_t bucketValue(std::size_t index)
+	{
+		if(index < SUB_BUCKET_COUNT)
+			return index;
+
+		auto shift = index / SUB_BUCKET_COUNT - 1;
+		auto lowest = (SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+		return lowest + (std::uint64_t(1) << shift) - 1;
+	}
+
+public:
+	LatencyHistogram()
+	: _counts((64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT)
+	{}
+
+	void record(std::uint64_t value)
+	{
+		++_counts[bucketIndex(value)];
+		++_count;
+		_max = std::max(_max, value);
+	}
+
+	void merge(LatencyHistogram const& other)
+	{
+		for(std::size_t i = 0; i != _counts.size(); ++i)
+			_counts[i] += other._counts[i];
+
+		_count += other._count;
+		_max = std::max(_max, other._max);
+	}
+
+	std::uint64_t count() const
+	{
+		return _count;
+	}
+
+	std::uint64_t max() const
+	{
+		return _max;
+	}
+
+	// smallest value that at least the given fraction of the recorded values doesn't exceed, rounded up to the bucket
+	std::uint64_t percentile(double fraction) const
+	{
+		if(_count == 0)
+			return 0;
+
+		auto rank = std::max<std::uint64_t>(1, (std::uint64_t)(fraction * _count + 0.5));
+		std::uint64_t seen = 0;
+
+		for(std::size_t i = 0; i != _counts.size(); ++i)
+		{
+			seen += _counts[i];
+
+			if(seen >= rank)
+				return std::min(bucketValue(i), _max);
+		}
+
+		return _max;
+	}
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <mio/mio.hpp>
+
+#include "parser.hpp"
+#include "threadpool.hpp"
+
+namespace fs = std::filesystem;
+
+[[noreturn]]
+inline
+void fatalError(char const* fmt, ...)
+{
+	va_list list;
+	va_start(list, fmt);
+	std::vfprintf(stderr, fmt, list);
+	va_end(list);
+
+	std::exit(EXIT_FAILURE);
+}
+
+// parses <x>.<z>.bin with optionally negative integer region coordinates, a hand-written std::regex_match equivalent
+inline
+bool parseRegionFilename(std::string const& filename, int& x, int& z)
+{
+	std::size_t i = 0;
+
+	auto coordinate = [&](int& value)
+	{
+		auto negative = i != filename.size() && filename[i] == '-';
+
+		if(negative)
+			++i;
+
+		auto start = i;
+		value = 0;
+
+		while(i != filename.size() && std::isdigit((unsigned char)filename[i]))
+			value = 10 * value + (filename[i++] - '0');
+
+		if(negative)
+			value = -value;
+
+		return i != start;
+	};
+
+	auto literal = [&](char const* text)
+	{
+		for(; *text; ++text, ++i)
+			if(i == filename.size() || filename[i] != *text)
+				return false;
+
+		return true;
+	};
+
+	return coordinate(x) && literal(".") && coordinate(z) && literal(".bin") && i == filename.size();
+}
+
+inline
+bool isRegionFilename(std::string const& filename)
+{
+	int x, z;
+	return parseRegionFilename(filename, x, z);
+}
+
+template <typename FileHandler>
+void forEachRegionFile(fs::path const& directory, FileHandler handler)
+{
+	for(auto&& entry : fs::directory_iterator(directory))
+	{
+		if(!entry.is_regular_file())
+			continue;
+
+		if(isRegionFilename(entry.path().filename().u8string()))
+			handler(entry.path());
+	}
+}
+
+// parses the region and takes its coordinates from the filename
+inline
+Region parseRegion(fs::path const& path, std::uint8_t const* data)
+{
+	auto region = parseRegion(data);
+	parseRegionFilename(path.filename().u8string(), region.x, region.z);
+	return region;
+}
+
+inline
+mio::mmap_source mapRegionFile(fs::path const& path)
+{
+	std::error_code errc;
+	auto mapping = mio::make_mmap_source(path.string(), errc);
+
+	if(errc)
+		fatalError("failed to load region file '%s': %s\n", path.string().c_str(), errc.message().c_str());
+
+	return mapping;
+}
+
+// maps and parses every region file in the directory, the mappings must outlive the regions
+// files are mapped and parsed on the given number of threads, the regions keep the directory order
+inline
+void loadRegions(fs::path const& directory, std::vector<mio::mmap_source>& mappings, std::vector<Region>& regions,
+                 std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<fs::path> paths;
+	forEachRegionFile(directory, [&paths](fs::path const& path) { paths.push_back(path); });
+
+	auto first = regions.size();
+	mappings.resize(first + paths.size());
+	regions.resize(first + paths.size());
+
+	threads = std::min(threads, std::max<std::size_t>(paths.size(), 1));
+	WorkStealingRange range(threads, paths.size());
+	std::atomic<std::size_t> bytes{0};
+
+	runWorkers(threads, [&](std::size_t worker)
+	{
+		std::size_t item;
+
+		while(range.next(worker, item))
+		{
+			mappings[first + item] = mapRegionFile(paths[item]);
+			regions[first + item] = parseRegion(paths[item], (std::uint8_t const*)mappings[first + item].data());
+			bytes += mappings[first + item].size();
+		}
+	});
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1e6f;
+
+	std::printf("loaded %zu region files (%.2f MiB) on %zu threads in %.3f s", paths.size(), bytes / 1024.f / 1024.f, threads, duration);
+
+	if(duration != 0)
+		std::printf(", %.2f MiB/s", bytes / 1024.f / 1024.f / duration);
+
+	std::printf("\n");
+	std::printf("\n");
+}
+
+// reads one byte of every page of the mappings, so the first benchmark doesn't pay for the page faults
+// parsing only touches the chunk headers, most of the section data hasn't been read in yet
+inline
+void prefaultMappings(std::vector<mio::mmap_source> const& mappings)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	auto pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+	std::size_t bytes = 0;
+
+	for(auto& mapping : mappings)
+	{
+		madvise((void*)mapping.data(), mapping.size(), MADV_WILLNEED);
+
+		for(std::size_t i = 0; i < mapping.size(); i += pageSize)
+			(void)((char const volatile*)mapping.data())[i];
+
+		bytes += mapping.size();
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1e6f;
+
+	std::printf("pre-faulted %.2f MiB in %.3f s\n", bytes / 1024.f / 1024.f, duration);
+	std::printf("\n");
+}
+
+// visits the region files of a directory one at a time, so only the current region and optionally the next one are
+// mapped at any point, no matter how large the world is
+// with prefetching enabled, a background thread maps the next file and asks the kernel to start reading it in while
+// the current region is being processed
+class RegionStream
+{
+	std::vector<fs::path> _paths;
+	std::size_t _next = 0;
+	bool _prefetch;
+	std::thread _prefetchThread;
+	mio::mmap_source _prefetched;
+
+public:
+	RegionStream(fs::path const& directory, bool prefetch)
+	: _prefetch(prefetch)
+	{
+		forEachRegionFile(directory, [this](fs::path const& path) { _paths.push_back(path); });
+		startPrefetch();
+	}
+
+	RegionStream(RegionStream const&) = delete;
+	RegionStream& operator=(RegionStream const&) = delete;
+
+	~RegionStream()
+	{
+		if(_prefetchThread.joinable())
+			_prefetchThread.join();
+	}
+
+	std::size_t size() const
+	{
+		return _paths.size();
+	}
+
+	// unmaps the previous region and replaces it with the next one, returns false once every file has been visited
+	// the regions sections point into mapping, so it has to stay alive as long as region is used
+	bool next(mio::mmap_source& mapping, Region& region)
+	{
+		mapping.unmap();
+
+		if(_next == _paths.size())
+			return false;
+
+		std::printf("streaming region file '%s' (%zu/%zu) ...\n", _paths[_next].filename().u8string().c_str(), _next + 1, _paths.size());
+
+		if(_prefetchThread.joinable())
+		{
+			_prefetchThread.join();
+			mapping = std::move(_prefetched);
+		}
+		else
+			mapping = mapRegionFile(_paths[_next]);
+
+		region = parseRegion(_paths[_next], (std::uint8_t const*)mapping.data());
+		++_next;
+
+		startPrefetch();
+		return true;
+	}
+
+private:
+	void startPrefetch()
+	{
+		if(!_prefetch || _next == _paths.size())
+			return;
+
+		_prefetchThread = std::thread([this, path = _paths[_next]]
+		{
+			_prefetched = mapRegionFile(path);
+
+			// the mapping starts at offset 0 of the file, so it is page aligned
+			madvise((void*)_prefetched.data(), _prefetched.size(), MADV_WILLNEED);
+		});
+	}
+};
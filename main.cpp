@@ -1,104 +1,52 @@
-#include <cstdarg>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
-#include <chrono>
-#include <filesystem>
-#include <regex>
-#include <utility>
-
-#include <mio/mio.hpp>
-
-#include "compressors/null.hpp"
-#include "compressors/brotli.hpp"
-#include "compressors/bzip2.hpp"
-#include "compressors/libdeflate.hpp"
-#include "compressors/lz4.hpp"
-#include "compressors/zlib.hpp"
-#include "compressors/zstd.hpp"
+#include <string>
+#include <vector>
+
+#include "allocationhook.hpp"
+#include "benchmark.hpp"
+#include "chunkcache.hpp"
+#include "compressors/zstddict.hpp"
+#include "loader.hpp"
+#include "pareto.hpp"
 #include "parser.hpp"
-#include "schemes/vanilla.hpp"
-#include "schemes/opt1.hpp"
-#include "schemes/opt2.hpp"
-
-namespace fs = std::filesystem;
-
-std::regex const REGION_FILENAME_PATTERN(R"(([-]?\d+)\.([-]?\d+)\.bin)");
-
-[[noreturn]]
-inline
-void fatalError(char const* fmt, ...)
-{
-	va_list list;
-	va_start(list, fmt);
-	std::vfprintf(stderr, fmt, list);
-	va_end(list);
-
-	std::exit(EXIT_FAILURE);
-}
-
-template <typename FileHandler>
-void forEachRegionFile(fs::path const& directory, FileHandler handler)
-{
-	for(auto&& entry : fs::directory_iterator(directory))
-	{
-		if(!entry.is_regular_file())
-			continue;
-
-		auto filename = entry.path().filename().u8string();
-		std::smatch match;
-
-		if(std::regex_match(filename, match, REGION_FILENAME_PATTERN))
-			handler(entry.path());
-	}
-}
-
-std::size_t countNonAirBlocks(std::uint16_t const* section)
-{
-	std::size_t result = 0;
-
-	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
-		if(section[i])
-			++result;
-
-	return result;
-}
+#include "registry.hpp"
+#include "results.hpp"
+#include "sampling.hpp"
+#include "sweep.hpp"
+#include "tuner.hpp"
 
 void stats(std::vector<Region> const& regions)
 {
 	std::size_t chunkCount = 0;
 	std::size_t sectionCount = 0;
-	std::size_t sectionBitDepthCounts[12] = {};
+	std::size_t sectionBitDepthCounts[13] = {};
 	std::size_t blockCountBitDepths[13] = {};
 	std::size_t blockCountBitDepthsWith4BitId[13] = {};
 	std::size_t size = 0;
+	std::size_t indexSize = 0;
 
 	for(auto& region : regions)
 	{
-		for(auto& chunk : region.chunks)
-		{
-			if(!chunk)
-				continue;
-
-			++chunkCount;
+		chunkCount += region.chunks.size();
+		indexSize += sizeof region + region.sections.size() * sizeof *region.sections.data() + region.chunks.size() * sizeof(Chunk);
 
-			for(auto& section : chunk->sections)
-			{
-				if(!section)
-					continue;
-
-				++sectionCount;
-				size += sizeof **section * BLOCKS_PER_SECTION;
+		for(auto section : region.sections)
+		{
+			++sectionCount;
+			size += sizeof *section * BLOCKS_PER_SECTION;
 
-				auto palette = createPalette(*section, BLOCKS_PER_SECTION, true);
-				auto paletteBits = ceillog2(palette.size);
-				++sectionBitDepthCounts[paletteBits];
+			auto palette = createPalette(section, BLOCKS_PER_SECTION, true);
+			auto paletteBits = ceillog2(palette.size);
+			++sectionBitDepthCounts[paletteBits];
 
-				auto nonAirBlockBits = ceillog2(countNonAirBlocks(*section));
-				++blockCountBitDepths[nonAirBlockBits];
+			auto nonAirBlockBits = ceillog2(countNonAirBlocks(section));
+			++blockCountBitDepths[nonAirBlockBits];
 
-				if(paletteBits <= 4)
-					++blockCountBitDepthsWith4BitId[nonAirBlockBits];
-			}
+			if(paletteBits <= 4)
+				++blockCountBitDepthsWith4BitId[nonAirBlockBits];
 		}
 	}
 
@@ -106,6 +54,7 @@ void stats(std::vector<Region> const& regions)
 	std::printf("regions: %zu\n", regions.size());
 	std::printf("chunks: %zu\n", chunkCount);
 	std::printf("sections: %zu\n", sectionCount);
+	std::printf("section index: %.2f KiB\n", indexSize / 1024.f);
 	std::printf("bits per section:\n");
 
 	for(auto i = 0; i != sizeof sectionBitDepthCounts / sizeof *sectionBitDepthCounts; ++i)
@@ -133,95 +82,480 @@ void stats(std::vector<Region> const& regions)
 	std::printf("\n");
 }
 
-template <typename Scheme>
-void benchmark(std::vector<Region> const& regions, Scheme scheme)
+// trains the zstd dictionary on the opt2 payloads of chunks spread evenly over the world
+// zdict recommends about 100 times the dictionary size as training input, which ~1000 chunks easily provide
+ZstdDictionary trainChunkDictionary(std::vector<Region> const& regions, PaletteOrder order, BlockOrder blockOrder)
 {
-	auto startTime = std::chrono::high_resolution_clock::now();
+	constexpr std::size_t MAX_SAMPLE_CHUNKS = 1024;
 
-	std::size_t size = 0;
+	std::vector<Chunk const*> chunks;
 
 	for(auto& region : regions)
-	{
-		scheme.beginRegion(region);
-
 		for(auto& chunk : region.chunks)
-		{
-			if(!chunk)
-				continue;
+			chunks.push_back(&chunk);
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	ChunkCache samples;
+	auto sampleCount = std::min(chunks.size(), MAX_SAMPLE_CHUNKS);
+
+	for(std::size_t i = 0; i != sampleCount; ++i)
+		samples.append(*chunks[i * chunks.size() / sampleCount], order, blockOrder);
 
-			scheme.beginChunk(*chunk);
+	std::vector<std::size_t> sampleSizes;
 
-			for(auto& section : chunk->sections)
-			{
-				if(!section)
-					continue;
+	for(std::size_t i = 0; i != samples.chunkCount(); ++i)
+		sampleSizes.push_back(samples.chunkSize(i));
 
-				size += scheme.section(*section);
-			}
+	auto dictionary = trainZstdDictionary(samples.data(), sampleSizes);
 
-			size += scheme.endChunk();
+	if(!dictionary)
+		return dictionary;
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() / 1000.f;
+
+	std::printf("zstd dictionary: %.2f KiB, trained on %zu chunks (%.2f MiB) in %.2f s\n",
+	            dictionary->size() / 1024.f, sampleCount, samples.size() / 1024.f / 1024.f, duration);
+	std::printf("\n");
+
+	return dictionary;
+}
+
+struct Options
+{
+	std::size_t threads = 1;
+	std::size_t sweepThreads = 0;
+	bool decode = false;
+	bool latency = false;
+	bool cached = false;
+	bool stream = false;
+	bool prefetch = true;
+	// csv or json file to write the results to, chosen by the extension
+	std::string output;
+	// selection of the configurations, all empty runs the default list
+	std::string scheme;
+	std::string compressor;
+	std::vector<int> levels;
+	std::size_t chunksPerFrame = 16;
+	PaletteOrder paletteOrder = PaletteOrder::firstSeen;
+	BlockOrder blockOrder = BlockOrder::linear;
+	Repetitions repetitions;
+	bool prefault = true;
+	// core to run single threaded benchmarks on, negative to leave the scheduler free
+	long pin = -1;
+	// benchmark only this many chunks spread over the world, 0 for all of them
+	std::size_t sample = 0;
+	// fraction of the chunks to extrapolate the whole world from, 0 to measure it
+	double estimate = 0;
+	bool tune = false;
+	TuningTarget target;
+};
+
+std::vector<Configuration> makeConfigurations(Options const& options, std::vector<Region> const& regions)
+{
+	ZstdDictionary dictionary;
+	bool trained = false;
+	SchemeParameters parameters;
+	parameters.chunksPerFrame = options.chunksPerFrame;
+	parameters.paletteOrder = options.paletteOrder;
+	parameters.blockOrder = options.blockOrder;
+	parameters.dictionary = [&]
+	{
+		// a failed training isn't repeated for every configuration
+		if(!trained)
+		{
+			dictionary = trainChunkDictionary(regions, options.paletteOrder, options.blockOrder);
+			trained = true;
 		}
 
-		size += scheme.endRegion();
+		return dictionary;
+	};
+
+	std::vector<Configuration> configurations;
+
+	auto add = [&](std::string const& scheme, std::string const& compressor, std::vector<int> const& levels)
+	{
+		for(auto& configuration : makeConfigurations(scheme, compressor, levels, parameters))
+			configurations.push_back(configuration);
+	};
+
+	if(!options.scheme.empty() || !options.compressor.empty() || !options.levels.empty())
+	{
+		add(options.scheme.empty() ? "opt2" : options.scheme, options.compressor, options.levels);
+		return configurations;
+	}
+
+	add("vanilla", "", {});
+	add("opt1", "", {});
+	add("opt2", "", {});
+	add("adaptive", "", {});
+	add("rle", "zstd", {});
+	add("shared", "zstd", {});
+	add("predictive", "zstd", {});
+
+	for(std::size_t chunksPerFrame : {1, 4, 16, 1024})
+	{
+		parameters.chunksPerFrame = chunksPerFrame;
+		add("region", "zstd", {3, 9});
 	}
 
+	return configurations;
+}
+
+// regions are mapped, benchmarked with every configuration and unmapped one at a time, so memory use doesn't grow
+// with the size of the world
+void runStreaming(fs::path const& directory, Options const& options, ResultWriter& output)
+{
+	RegionStream stream(directory, options.prefetch);
+	mio::mmap_source mapping;
+	std::vector<Region> current(1);
+
+	if(!stream.next(mapping, current[0]))
+		fatalError("no region files in '%s'\n", directory.string().c_str());
+
+	// without the whole world at hand, the dictionary is trained on the first region only
+	auto configurations = makeConfigurations(options, current);
+	std::vector<BenchmarkResult> results(configurations.size());
+
+	do
+	{
+		for(std::size_t i = 0; i != configurations.size(); ++i)
+			accumulate(results[i], configurations[i].benchmark(current));
+	}
+	while(stream.next(mapping, current[0]));
+
+	std::printf("\n");
+
+	for(auto& result : results)
+	{
+		printResult(result);
+		output.add(result, "stream");
+	}
+}
+
+// compressor-only mode: the opt2 payloads are encoded once up front and every configuration that can compress them
+// directly is fed from that cache
+void runCached(std::vector<Region> const& regions, Options const& options, std::vector<Configuration> const& configurations, ResultWriter& output)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	auto cache = buildChunkCache(regions, std::max<std::size_t>(options.sweepThreads, 1), options.paletteOrder, options.blockOrder);
 	auto endTime = std::chrono::high_resolution_clock::now();
 	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() / 1000.f;
 
-	std::printf("scheme: %s\n", scheme.name().c_str());
-	std::printf("size: %.2f MiB\n", size / 1024.f / 1024.f);
-	std::printf("time: %.2f s\n", duration);
+	std::printf("chunk cache: %zu chunks, %.2f MiB payload from %.2f MiB of sections, built in %.2f s\n",
+	            cache.chunkCount(), cache.size() / 1024.f / 1024.f, cache.inputSize() / 1024.f / 1024.f, duration);
 	std::printf("\n");
+
+	std::vector<Configuration> cacheable;
+
+	for(auto& configuration : configurations)
+		if(configuration.benchmarkCached)
+			cacheable.push_back(configuration);
+
+	if(options.sweepThreads != 0)
+	{
+		for(auto& result : sweep(cache, cacheable, options.sweepThreads, options.repetitions))
+			output.add(result, "cached");
+
+		return;
+	}
+
+	for(auto& configuration : cacheable)
+	{
+		auto result = repeatBenchmark(options.repetitions, [&] { return configuration.benchmarkCached(cache); });
+		printResult(result);
+		output.add(result, "cached");
+	}
 }
 
-int main(int argc, char** argv)
+// runs every configuration on a stratified sample and extrapolates the results of the whole world
+void runEstimate(std::vector<Region> const& regions, Options const& options, std::vector<Configuration> const& configurations, ResultWriter& output)
 {
-	auto args = std::vector(argv, argv + argc);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	auto sample = stratifiedSample(regions, options.estimate);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() / 1000.f;
+
+	std::size_t sampleChunks = 0;
+	std::size_t chunks = 0;
+
+	for(std::size_t i = 0; i != sample.strata.size(); ++i)
+	{
+		sampleChunks += sample.strata[i].chunks.size();
+		chunks += sample.populations[i];
+	}
 
-	if(args.size() != 2)
-		fatalError("invalid args, expected %s <region-dir>\n", args[0]);
+	std::printf("stratified sample: %zu of %zu chunks in %zu strata, built in %.2f s\n", sampleChunks, chunks, sample.strata.size(), duration);
+	std::printf("\n");
+
+	if(options.sweepThreads != 0)
+	{
+		for(auto& result : sweep(sample, configurations, options.sweepThreads, options.repetitions))
+			output.add(result, "estimate");
 
-	std::vector<mio::mmap_source> mappings;
-	std::vector<Region> regions;
+		return;
+	}
 
-	forEachRegionFile(args[1], [&mappings, &regions](fs::path const& path)
+	for(auto& configuration : configurations)
 	{
-		std::printf("loading region file '%s' ...\n", path.filename().u8string().c_str());
+		auto result = repeatBenchmark(options.repetitions, [&] { return configuration.benchmarkSampled(sample); });
+		printResult(result);
+		output.add(result, "estimate");
+	}
+}
 
-		std::error_code errc;
-		auto mapping = mio::make_mmap_source(path.string(), errc);
+// measures compression and decompression of every configuration and recommends the one that best meets the target
+void runTuning(std::vector<Region> const& regions, Options const& options, std::vector<Configuration> const& configurations, ResultWriter& output)
+{
+	std::vector<BenchmarkResult> compressResults;
 
-		if(errc)
-			fatalError("failed to load region file '%s': %s\n", path.string().c_str(), errc.message().c_str());
+	if(options.sweepThreads != 0)
+		compressResults = sweep(regions, configurations, options.sweepThreads, options.repetitions);
+	else
+	{
+		for(auto& configuration : configurations)
+		{
+			compressResults.push_back(repeatBenchmark(options.repetitions, [&] { return configuration.benchmark(regions); }));
+			printResult(compressResults.back());
+		}
+	}
 
-		auto region = parseRegion((std::uint8_t const*)mapping.data());
-		mappings.emplace_back(std::move(mapping));
-		regions.emplace_back(region);
-	});
+	std::vector<BenchmarkResult> decompressResults;
 
-	std::printf("done loading regions\n");
-	std::printf("\n");
+	for(auto& configuration : configurations)
+		decompressResults.push_back(configuration.benchmarkDecode(regions));
+
+	for(auto& result : compressResults)
+		output.add(result, "compress");
+
+	printTuning(compressResults, decompressResults, options.target);
+}
+
+void run(std::vector<Region> const& regions, Options const& options, std::vector<Configuration> const& configurations, ResultWriter& output)
+{
+	if(options.tune)
+	{
+		runTuning(regions, options, configurations, output);
+		return;
+	}
+
+	if(options.estimate != 0)
+	{
+		runEstimate(regions, options, configurations, output);
+		return;
+	}
+
+	if(options.cached)
+	{
+		runCached(regions, options, configurations, output);
+		return;
+	}
+
+	if(options.sweepThreads != 0)
+	{
+		for(auto& result : sweep(regions, configurations, options.sweepThreads, options.repetitions))
+			output.add(result, "compress");
+
+		return;
+	}
+
+	for(auto& configuration : configurations)
+	{
+		if(options.decode)
+			configuration.benchmarkDecode(regions);
+		else if(options.latency)
+			configuration.benchmarkLatency(regions);
+		else if(options.threads == 1)
+		{
+			auto result = repeatBenchmark(options.repetitions, [&] { return configuration.benchmark(regions); });
+			printResult(result);
+			output.add(result, "compress");
+		}
+		else
+		{
+			for(auto& result : configuration.benchmarkParallel(regions, options.threads))
+				output.add(result, "compress");
+		}
+	}
+}
+
+Options parseOptions(std::vector<char*> const& args)
+{
+	Options options;
+
+	for(std::size_t i = 2; i != args.size(); ++i)
+	{
+		auto arg = std::string(args[i]);
+
+		if(arg == "--threads" && i + 1 != args.size())
+		{
+			options.threads = std::strtoul(args[++i], nullptr, 10);
+
+			if(options.threads == 0)
+				fatalError("invalid thread count '%s'\n", args[i]);
+		}
+		else if(arg == "--sweep" && i + 1 != args.size())
+		{
+			options.sweepThreads = std::strtoul(args[++i], nullptr, 10);
+
+			if(options.sweepThreads == 0)
+				fatalError("invalid thread count '%s'\n", args[i]);
+		}
+		else if(arg == "--decode")
+			options.decode = true;
+		else if(arg == "--latency")
+			options.latency = true;
+		else if(arg == "--cached")
+			options.cached = true;
+		else if(arg == "--stream")
+			options.stream = true;
+		else if(arg == "--no-prefetch")
+			options.prefetch = false;
+		else if(arg == "--scheme" && i + 1 != args.size())
+			options.scheme = args[++i];
+		else if(arg == "--compressor" && i + 1 != args.size())
+		{
+			options.compressor = args[++i];
+			findCompressor(options.compressor);
+		}
+		else if(arg == "--levels" && i + 1 != args.size())
+			options.levels = parseLevels(args[++i]);
+		else if(arg == "--frame" && i + 1 != args.size())
+		{
+			options.chunksPerFrame = std::strtoul(args[++i], nullptr, 10);
 
-	stats(regions);
-	benchmark(regions, VanillaCompressionScheme());
-	benchmark(regions, Opt1CompressionScheme());
+			if(options.chunksPerFrame == 0)
+				fatalError("invalid frame size '%s'\n", args[i]);
+		}
+		else if(arg == "--frequency-palettes")
+			options.paletteOrder = PaletteOrder::frequency;
+		else if(arg == "--block-order" && i + 1 != args.size())
+			options.blockOrder = parseBlockOrder(args[++i]);
+		else if(arg == "--repeat" && i + 1 != args.size())
+		{
+			options.repetitions.count = std::strtoul(args[++i], nullptr, 10);
 
-	benchmark(regions, Opt2CompressionScheme<NullCompressor>());
+			if(options.repetitions.count == 0)
+				fatalError("invalid repeat count '%s'\n", args[i]);
+		}
+		else if(arg == "--warmup" && i + 1 != args.size())
+			options.repetitions.warmup = std::strtoul(args[++i], nullptr, 10);
+		else if(arg == "--pin" && i + 1 != args.size())
+		{
+			char* end;
+			options.pin = std::strtol(args[++i], &end, 10);
 
-	//for(int i = 1; i <= 250; i += 10)
-	//	benchmark(regions, Opt2CompressionScheme<Bzip2Compressor>(i));
+			if(*end != '\0' || options.pin < 0)
+				fatalError("invalid core '%s'\n", args[i]);
+		}
+		else if(arg == "--no-prefault")
+			options.prefault = false;
+		else if(arg == "--sample" && i + 1 != args.size())
+		{
+			options.sample = std::strtoul(args[++i], nullptr, 10);
+
+			if(options.sample == 0)
+				fatalError("invalid sample size '%s'\n", args[i]);
+		}
+		else if(arg == "--estimate" && i + 1 != args.size())
+		{
+			char* end;
+			options.estimate = std::strtod(args[++i], &end);
+
+			if(*end != '\0' || !(options.estimate > 0 && options.estimate <= 1))
+				fatalError("invalid sample fraction '%s', expected a number in (0, 1]\n", args[i]);
+		}
+		else if(arg == "--tune" && i + 1 != args.size())
+		{
+			options.tune = true;
+			options.target = parseTuningTarget(args[++i]);
+		}
+		else if(arg == "--output" && i + 1 != args.size())
+		{
+			options.output = args[++i];
+			auto extension = fs::path(options.output).extension();
+
+			if(extension != ".csv" && extension != ".json")
+				fatalError("invalid output file '%s', expected a .csv or .json file\n", args[i]);
+		}
+		else
+			fatalError("invalid argument '%s'\n", args[i]);
+	}
 
-	for(int i = 0; i <= 8; ++i)
-		benchmark(regions, Opt2CompressionScheme<BrotliCompressor>(i));
+	// the modes exclude each other, except that a sweep can run over cached payloads or a sample, or measure the
+	// compression of a tuning run
+	auto estimate = options.estimate != 0;
+	auto modeCount = options.decode + options.latency + options.cached + options.stream + options.tune + estimate
+	                 + (options.threads != 1) + (options.sweepThreads != 0);
 
-	for(int i = 1; i <= 8; ++i)
-		benchmark(regions, Opt2CompressionScheme<ZlibCompressor>(i));
+	if(modeCount > 1 && !(modeCount == 2 && (options.cached || options.tune || estimate) && options.sweepThreads != 0))
+		fatalError("only one of --cached, --tune or --estimate and --sweep can be combined\n");
 
-	for(int i = 1; i <= 9; ++i)
-		benchmark(regions, Opt2CompressionScheme<LibDeflateCompressor>(i));
+	if(options.sample != 0 && options.stream)
+		fatalError("--sample can't be combined with --stream\n");
+
+	// the parallel, decoding, latency and streaming runs aren't single measurements that could be repeated
+	auto repeated = options.repetitions.count != 1 || options.repetitions.warmup != 0;
+
+	if(repeated && (options.decode || options.latency || options.stream || options.threads != 1))
+		fatalError("--repeat and --warmup can't be combined with --threads, --decode, --latency or --stream\n");
+
+	if(options.pin >= 0 && (options.threads != 1 || options.sweepThreads != 0))
+		fatalError("--pin only applies to single threaded runs\n");
+
+	// decoding and latencies don't produce the size and throughput records the output files are made of
+	if(!options.output.empty() && (options.decode || options.latency))
+		fatalError("--output can't be combined with --decode or --latency\n");
+
+	return options;
+}
+
+int main(int argc, char** argv)
+{
+	auto args = std::vector(argv, argv + argc);
+
+	if(args.size() < 2)
+		fatalError("invalid args, expected %s <region-dir> [--scheme <vanilla|opt1|opt2|region|adaptive|rle|shared|predictive>] [--compressor <name>] [--levels <levels>] "
+		           "[--frame <chunks>] [--frequency-palettes] [--block-order <linear|morton|hilbert>] [--repeat <count>] [--warmup <count>] [--pin <core>] [--no-prefault] "
+		           "[--sample <chunks>] [--estimate <fraction>] [--tune <target>] [--threads <count> | --sweep <count>] "
+		           "[--decode | --latency | --cached | --stream [--no-prefetch]] [--output <file.csv|file.json>]\n", args[0]);
+
+	auto options = parseOptions(args);
+
+	if(options.pin >= 0 && !pinThread(options.pin))
+		fatalError("failed to pin to core %ld\n", options.pin);
+
+	ResultWriter output;
+
+	if(options.stream)
+		runStreaming(args[1], options, output);
+	else
+	{
+		std::vector<mio::mmap_source> mappings;
+		std::vector<Region> regions;
+		loadRegions(args[1], mappings, regions);
+
+		if(options.prefault)
+			prefaultMappings(mappings);
+
+		stats(regions);
+
+		if(options.sample != 0)
+		{
+			std::vector<Region> sample{spreadSample(regions, options.sample)};
+			std::printf("sample: %zu chunks, %zu sections\n", sample[0].chunks.size(), sample[0].sections.size());
+			std::printf("\n");
+			run(sample, options, makeConfigurations(options, sample), output);
+		}
+		else
+			run(regions, options, makeConfigurations(options, regions), output);
+	}
 
-	for(int i = 0; i <= 12; ++i)
-		benchmark(regions, Opt2CompressionScheme<ZstdCompressor>(i));
+	// tuning prints its own frontiers
+	if(!options.tune)
+		printParetoFrontier(output.results());
 
-	benchmark(regions, Opt2CompressionScheme<Lz4Compressor>(0));
+	if(!options.output.empty())
+		output.write(options.output);
 }
@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "bitpacking.hpp"
+#include "blockorder.hpp"
+#include "loader.hpp"
+#include "palette.hpp"
+#include "palettepack.hpp"
+#include "parser.hpp"
+
+using BitpackKernel = std::size_t (*)(std::uint16_t const*, std::size_t, std::uint8_t*);
+
+BitpackKernel const SCALAR_BITPACK_KERNELS[] =
+{
+	nullptr, bitpack16to1, bitpack16to2, bitpack16to3, bitpack16to4,
+	bitpack16to5, bitpack16to6, bitpack16to7, bitpack16to8,
+};
+
+BitpackKernel const VECTORIZED_BITPACK_KERNELS[] =
+{
+	nullptr, bitpack16to1Vectorized, bitpack16to2Vectorized, bitpack16to3Vectorized, bitpack16to4Vectorized,
+	bitpack16to5Vectorized, bitpack16to6Vectorized, bitpack16to7Vectorized, bitpack16to8Vectorized,
+};
+
+constexpr std::size_t MAX_SAMPLE_SECTIONS_PER_BIN = 1024;
+
+// runs the kernel over every sample section until enough time has passed for a stable measurement
+template <typename Kernel>
+double measureNanosPerSection(std::size_t sectionCount, Kernel kernel)
+{
+	constexpr auto MIN_DURATION = std::chrono::milliseconds(200);
+
+	// untimed pass to warm up caches and branch predictors
+	for(std::size_t i = 0; i != sectionCount; ++i)
+		kernel(i);
+
+	std::size_t iterations = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	auto endTime = startTime;
+
+	do
+	{
+		for(std::size_t i = 0; i != sectionCount; ++i)
+			kernel(i);
+
+		++iterations;
+		endTime = std::chrono::steady_clock::now();
+	}
+	while(endTime - startTime < MIN_DURATION);
+
+	auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	return (double)nanos / (iterations * sectionCount);
+}
+
+// sample sections binned by the number of bits bitpackOptimized uses for them
+std::vector<std::vector<std::uint16_t const*>> sampleSections(std::vector<Region> const& regions)
+{
+	std::vector<std::vector<std::uint16_t const*>> bins(13);
+
+	for(auto& region : regions)
+	{
+		for(auto section : region.sections)
+		{
+			auto palette = createPalette(section, BLOCKS_PER_SECTION, true);
+			auto& bin = bins[ceillog2(palette.size)];
+
+			if(bin.size() != MAX_SAMPLE_SECTIONS_PER_BIN)
+				bin.push_back(section);
+		}
+	}
+
+	return bins;
+}
+
+// the sample sections palettized into contiguous buffers, one per bin
+std::vector<std::vector<std::uint16_t>> samplePalettizedSections(std::vector<Region> const& regions)
+{
+	auto sectionBins = sampleSections(regions);
+	std::vector<std::vector<std::uint16_t>> bins(sectionBins.size());
+
+	for(std::size_t i = 0; i != bins.size(); ++i)
+	{
+		bins[i].resize(sectionBins[i].size() * BLOCKS_PER_SECTION);
+
+		for(std::size_t j = 0; j != sectionBins[i].size(); ++j)
+		{
+			auto section = sectionBins[i][j];
+			auto palette = createPalette(section, BLOCKS_PER_SECTION, true);
+			palettize(palette, section, BLOCKS_PER_SECTION, bins[i].data() + j * BLOCKS_PER_SECTION, true);
+		}
+	}
+
+	return bins;
+}
+
+void benchmarkBitpacking(std::vector<Region> const& regions)
+{
+	auto bins = samplePalettizedSections(regions);
+	auto vectorized = bitpackVectorizedSupported();
+
+	std::printf("bitpacking (ns/section):\n");
+
+	if(!vectorized)
+		std::printf("\tCPU lacks AVX2/BMI2, measuring scalar kernels only\n");
+
+	std::vector<std::uint8_t> scalarOut(2 * BLOCKS_PER_SECTION);
+	std::vector<std::uint8_t> vectorizedOut(2 * BLOCKS_PER_SECTION);
+
+	for(int bits = 1; bits <= 8; ++bits)
+	{
+		auto& bin = bins[bits];
+		auto sectionCount = bin.size() / BLOCKS_PER_SECTION;
+
+		if(sectionCount == 0)
+			continue;
+
+		auto scalar = SCALAR_BITPACK_KERNELS[bits];
+		auto scalarTime = measureNanosPerSection(sectionCount, [&](std::size_t i)
+		{
+			scalar(bin.data() + i * BLOCKS_PER_SECTION, BLOCKS_PER_SECTION, scalarOut.data());
+		});
+
+		if(!vectorized)
+		{
+			std::printf("\t%d bits: scalar %.1f (%zu sections)\n", bits, scalarTime, sectionCount);
+			continue;
+		}
+
+		auto kernel = VECTORIZED_BITPACK_KERNELS[bits];
+		auto vectorizedTime = measureNanosPerSection(sectionCount, [&](std::size_t i)
+		{
+			kernel(bin.data() + i * BLOCKS_PER_SECTION, BLOCKS_PER_SECTION, vectorizedOut.data());
+		});
+
+		std::size_t mismatches = 0;
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+		{
+			auto size = scalar(bin.data() + i * BLOCKS_PER_SECTION, BLOCKS_PER_SECTION, scalarOut.data());
+
+			if(kernel(bin.data() + i * BLOCKS_PER_SECTION, BLOCKS_PER_SECTION, vectorizedOut.data()) != size
+			|| std::memcmp(scalarOut.data(), vectorizedOut.data(), size) != 0)
+				++mismatches;
+		}
+
+		std::printf("\t%d bits: scalar %.1f, vectorized %.1f, speedup %.2fx (%zu sections)\n",
+		            bits, scalarTime, vectorizedTime, scalarTime / vectorizedTime, sectionCount);
+
+		if(mismatches)
+			std::printf("\t\tERROR: %zu sections differ from the scalar output\n", mismatches);
+	}
+
+	std::printf("\n");
+}
+
+void benchmarkPalettePack(std::vector<Region> const& regions)
+{
+	auto bins = sampleSections(regions);
+
+	std::printf("palettize + bitpack (ns/section):\n");
+
+	std::vector<std::uint8_t> separateOut(2 * BLOCKS_PER_SECTION);
+	std::vector<std::uint8_t> fusedOut(2 * BLOCKS_PER_SECTION);
+
+	for(int bits = 1; bits <= 12; ++bits)
+	{
+		auto& sections = bins[bits];
+
+		if(sections.empty())
+			continue;
+
+		std::vector<Palette> palettes;
+
+		for(auto section : sections)
+			palettes.push_back(createPalette(section, BLOCKS_PER_SECTION, false));
+
+		auto separate = [&](std::size_t i, bool vectorize)
+		{
+			std::uint16_t buf[BLOCKS_PER_SECTION];
+			palettize(palettes[i], sections[i], BLOCKS_PER_SECTION, buf, vectorize);
+			return bitpackOptimized(palettes[i].size, buf, BLOCKS_PER_SECTION, separateOut.data(), vectorize);
+		};
+
+		auto fused = [&](std::size_t i)
+		{
+			return palettizeAndPackOptimized(palettes[i], sections[i], BLOCKS_PER_SECTION, fusedOut.data());
+		};
+
+		auto scalarTime = measureNanosPerSection(sections.size(), [&](std::size_t i) { separate(i, false); });
+		auto vectorizedTime = measureNanosPerSection(sections.size(), [&](std::size_t i) { separate(i, true); });
+		auto fusedTime = measureNanosPerSection(sections.size(), fused);
+
+		std::size_t mismatches = 0;
+
+		for(std::size_t i = 0; i != sections.size(); ++i)
+		{
+			auto size = separate(i, false);
+
+			if(fused(i) != size || std::memcmp(separateOut.data(), fusedOut.data(), size) != 0)
+				++mismatches;
+		}
+
+		std::printf("\t%d bits: separate scalar %.1f, separate vectorized %.1f, fused %.1f (%zu sections)\n",
+		            bits, scalarTime, vectorizedTime, fusedTime, sections.size());
+
+		if(mismatches)
+			std::printf("\t\tERROR: %zu sections differ from the separate output\n", mismatches);
+	}
+
+	std::printf("\n");
+}
+
+void benchmarkPalette(std::vector<Region> const& regions)
+{
+	auto bins = sampleSections(regions);
+
+	std::printf("palette creation (ns/section):\n");
+
+	for(std::size_t bits = 0; bits != bins.size(); ++bits)
+	{
+		auto& sections = bins[bits];
+
+		if(sections.empty())
+			continue;
+
+		auto linear = [&](std::size_t i)
+		{
+			Palette palette;
+			createPaletteLinear(sections[i], BLOCKS_PER_SECTION, &palette);
+			return palette;
+		};
+
+		auto vectorized = [&](std::size_t i) { return createPalette(sections[i], BLOCKS_PER_SECTION, true); };
+		auto bitmap = [&](std::size_t i) { return createPalette(sections[i], BLOCKS_PER_SECTION, false); };
+
+		auto bitmapTime = measureNanosPerSection(sections.size(), bitmap);
+		auto vectorizedTime = measureNanosPerSection(sections.size(), vectorized);
+		auto linearTime = measureNanosPerSection(sections.size(), linear);
+
+		std::size_t mismatches = 0;
+
+		for(std::size_t i = 0; i != sections.size(); ++i)
+		{
+			auto expected = linear(i);
+			auto actual = bitmap(i);
+
+			if(actual.size != expected.size || !std::equal(expected.values, expected.values + expected.size, actual.values))
+				++mismatches;
+		}
+
+		auto frequency = [&](std::size_t i) { return createPalette(sections[i], BLOCKS_PER_SECTION, true, PaletteOrder::frequency); };
+		auto frequencyTime = measureNanosPerSection(sections.size(), frequency);
+
+		std::printf("\t%zu bits: linear %.1f, vectorized %.1f, bitmap %.1f, frequency ordered %.1f (%zu sections)\n",
+		            bits, linearTime, vectorizedTime, bitmapTime, frequencyTime, sections.size());
+
+		if(mismatches)
+			std::printf("\t\tERROR: %zu palettes differ from the linear version\n", mismatches);
+	}
+
+	std::printf("palettize (ns/section):\n");
+
+	std::vector<std::uint16_t> out(BLOCKS_PER_SECTION);
+
+	for(std::size_t bits = 0; bits != bins.size(); ++bits)
+	{
+		auto& sections = bins[bits];
+
+		if(sections.empty())
+			continue;
+
+		std::vector<Palette> palettes;
+
+		for(auto section : sections)
+			palettes.push_back(createPalette(section, BLOCKS_PER_SECTION, false));
+
+		auto lookupTime = measureNanosPerSection(sections.size(), [&](std::size_t i)
+		{
+			palettize(palettes[i], sections[i], BLOCKS_PER_SECTION, out.data(), false);
+		});
+
+		if(palettes[0].size > VECTORIZED_PALETTE_SIZE)
+		{
+			std::printf("\t%zu bits: lookup table %.1f (%zu sections)\n", bits, lookupTime, sections.size());
+			continue;
+		}
+
+		auto vectorizedTime = measureNanosPerSection(sections.size(), [&](std::size_t i)
+		{
+			palettize(palettes[i], sections[i], BLOCKS_PER_SECTION, out.data(), true);
+		});
+
+		std::printf("\t%zu bits: vectorized %.1f, lookup table %.1f (%zu sections)\n", bits, vectorizedTime, lookupTime, sections.size());
+	}
+
+	std::printf("\n");
+}
+
+void benchmarkBlockOrder(std::vector<Region> const& regions)
+{
+	auto bins = sampleSections(regions);
+
+	std::printf("block order (ns/section):\n");
+
+	std::vector<std::uint16_t> reordered(BLOCKS_PER_SECTION);
+	std::vector<std::uint16_t> restored(BLOCKS_PER_SECTION);
+
+	for(auto order : {BlockOrder::morton, BlockOrder::hilbert})
+	{
+		for(std::size_t bits = 1; bits != bins.size(); ++bits)
+		{
+			auto& sections = bins[bits];
+
+			if(sections.empty())
+				continue;
+
+			auto reorderTime = measureNanosPerSection(sections.size(), [&](std::size_t i)
+			{
+				reorderBlocks(sections[i], order, reordered.data());
+			});
+
+			auto restoreTime = measureNanosPerSection(sections.size(), [&](std::size_t i)
+			{
+				restoreBlocks(sections[i], order, restored.data());
+			});
+
+			// changes between neighbouring blocks, every one of them ends a run the packing and the compressor see
+			std::size_t linearRuns = 0;
+			std::size_t orderedRuns = 0;
+
+			for(auto section : sections)
+			{
+				auto blocks = reorderBlocks(section, order, reordered.data());
+
+				for(std::size_t j = 1; j != BLOCKS_PER_SECTION; ++j)
+				{
+					linearRuns += section[j] != section[j - 1];
+					orderedRuns += blocks[j] != blocks[j - 1];
+				}
+			}
+
+			std::printf("\t%s %zu bits: reorder %.1f, restore %.1f, runs %.1f -> %.1f per section (%zu sections)\n",
+			            blockOrderName(order), bits, reorderTime, restoreTime, (double)linearRuns / sections.size(),
+			            (double)orderedRuns / sections.size(), sections.size());
+		}
+	}
+
+	std::printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	auto args = std::vector(argv, argv + argc);
+
+	if(args.size() < 2)
+		fatalError("invalid args, expected %s <region-dir> [bitpacking|palette|palettepack|blockorder]...\n", args[0]);
+
+	char const* const benchmarks[] = {"bitpacking", "palette", "palettepack", "blockorder"};
+
+	for(std::size_t i = 2; i != args.size(); ++i)
+	{
+		if(std::find_if(std::begin(benchmarks), std::end(benchmarks), [&](char const* name) { return args[i] == std::string(name); }) == std::end(benchmarks))
+			fatalError("unknown benchmark '%s'\n", args[i]);
+	}
+
+	std::vector<mio::mmap_source> mappings;
+	std::vector<Region> regions;
+	loadRegions(args[1], mappings, regions);
+
+	auto selected = [&args](char const* name)
+	{
+		if(args.size() == 2)
+			return true;
+
+		for(std::size_t i = 2; i != args.size(); ++i)
+			if(args[i] == std::string(name))
+				return true;
+
+		return false;
+	};
+
+	if(selected("bitpacking"))
+		benchmarkBitpacking(regions);
+
+	if(selected("palette"))
+		benchmarkPalette(regions);
+
+	if(selected("palettepack"))
+		benchmarkPalettePack(regions);
+
+	if(selected("blockorder"))
+		benchmarkBlockOrder(regions);
+}
@@ -4,21 +4,46 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <string>
 
 #include <immintrin.h>
 
+// a section can't have more distinct values than blocks
+constexpr std::size_t MAX_PALETTE_SIZE = 16 * 16 * 16;
+
+// number of entries the vectorized functions load unconditionally, unused ones are padded with 0xffff
+constexpr std::size_t VECTORIZED_PALETTE_SIZE = 64;
+
 struct Palette
 {
 	std::uint16_t size = 0;
-	std::uint16_t values[256];
+	std::uint16_t values[MAX_PALETTE_SIZE];
 
 	Palette()
 	{
-		for(auto& value : values)
-			value = 0xffff;
+		// entries past the vectorized range are only ever read below size, no need to initialize them
+		std::fill(values, values + VECTORIZED_PALETTE_SIZE, 0xffff);
 	}
 };
 
+// block id -> palette index, only the entries of the palette it was last filled with are valid
+// the table is 128 KiB, but only the few entries in use by a section are ever touched
+inline
+std::uint16_t* paletteIndexTable()
+{
+	static thread_local std::uint16_t table[1 << 16];
+	return table;
+}
+
+inline
+void fillPaletteIndexTable(Palette const& palette, std::uint16_t* table)
+{
+	for(std::size_t i = 0; i != palette.size; ++i)
+		table[palette.values[i]] = i;
+}
+
 inline
 bool tryCreatePaletteVectorized(std::uint16_t const* data, std::size_t count, Palette* out)
 {
@@ -72,16 +97,49 @@ bool tryCreatePaletteVectorized(std::uint16_t const* data, std::size_t count, Pa
 	return true;
 }
 
+// records values seen in a 65536-bit bitmap, which takes linear time regardless of the palette size
+// values already in the palette are kept, so this can continue where the vectorized version gave up
 inline
-Palette createPalette(std::uint16_t const* data, std::size_t count, bool vectorized)
+void createPaletteBitmap(std::uint16_t const* data, std::size_t count, Palette* out)
 {
-	Palette palette;
+	static thread_local std::uint64_t seen[(1 << 16) / 64];
 
-	if(vectorized && tryCreatePaletteVectorized(data, count, &palette))
-		return palette;
+	auto p = out->values;
+	auto size = out->size;
 
-	auto p = palette.values;
-	auto size = palette.size;
+	for(std::size_t i = 0; i != size; ++i)
+		seen[p[i] / 64] |= 1ull << (p[i] % 64);
+
+	for(std::size_t i = 0; i != count;)
+	{
+		auto value = data[i];
+
+		do ++i;
+		while(i != count && data[i] == value);
+
+		auto& word = seen[value / 64];
+		auto bit = 1ull << (value % 64);
+
+		if(word & bit)
+			continue;
+
+		word |= bit;
+		p[size++] = value;
+	}
+
+	// leave the bitmap empty for the next call, touching only the words in use
+	for(std::size_t i = 0; i != size; ++i)
+		seen[p[i] / 64] = 0;
+
+	out->size = size;
+}
+
+// the original scalar version, quadratic in the palette size, kept for comparison in the microbenchmarks
+inline
+void createPaletteLinear(std::uint16_t const* data, std::size_t count, Palette* out)
+{
+	auto p = out->values;
+	auto size = out->size;
 
 	for(std::size_t i = 0; i != count;)
 	{
@@ -95,13 +153,103 @@ Palette createPalette(std::uint16_t const* data, std::size_t count, bool vectori
 		if(it != p + size)
 			continue;
 
-		// in theory, we could get chunks with more than 256 distinct values, but not in test data for now
-		assert(size < 256);
-
 		p[size++] = value;
 	}
 
-	palette.size = size;
+	out->size = size;
+}
+
+inline
+Palette createPalette(std::uint16_t const* data, std::size_t count, bool vectorized)
+{
+	Palette palette;
+
+	if(vectorized && tryCreatePaletteVectorized(data, count, &palette))
+		return palette;
+
+	createPaletteBitmap(data, count, &palette);
+	return palette;
+}
+
+// the order palette entries are assigned their indices in
+enum class PaletteOrder
+{
+	firstSeen,
+	// the most common block gets index 0, so packed indices are mostly zero bits
+	frequency,
+};
+
+// suffix of the names of schemes using the given order, empty for the default
+inline
+std::string paletteOrderSuffix(PaletteOrder order)
+{
+	return order == PaletteOrder::frequency ? "-freq" : "";
+}
+
+// adds the number of occurrences of every palette entry to counts, indexed like the palette
+// 16 blocks are compared at once, so uniform stretches cost one vector comparison per 16 blocks
+inline
+void countPaletteEntries(Palette const& palette, std::uint16_t const* data, std::size_t count, std::uint32_t* counts)
+{
+	auto indices = paletteIndexTable();
+	fillPaletteIndexTable(palette, indices);
+
+	auto vectorCount = count / 16 * 16;
+
+	for(std::size_t i = 0; i != vectorCount; i += 16)
+	{
+		auto block = _mm256_loadu_si256((__m256i const*)(data + i));
+		auto first = _mm256_set1_epi16(data[i]);
+
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, first)) == -1)
+		{
+			counts[indices[data[i]]] += 16;
+			continue;
+		}
+
+		for(std::size_t j = i; j != i + 16; ++j)
+			++counts[indices[data[j]]];
+	}
+
+	for(std::size_t i = vectorCount; i != count; ++i)
+		++counts[indices[data[i]]];
+}
+
+// reorders the palette by decreasing counts, which are indexed like the palette, equally common entries keep their order
+inline
+void sortPaletteByCounts(Palette& palette, std::uint32_t const* counts)
+{
+	std::uint16_t order[MAX_PALETTE_SIZE];
+	std::iota(order, order + palette.size, 0);
+	std::stable_sort(order, order + palette.size, [&](std::uint16_t a, std::uint16_t b) { return counts[a] > counts[b]; });
+
+	std::uint16_t values[MAX_PALETTE_SIZE];
+
+	for(std::size_t i = 0; i != palette.size; ++i)
+		values[i] = palette.values[order[i]];
+
+	std::copy(values, values + palette.size, palette.values);
+}
+
+inline
+void sortPaletteByFrequency(Palette& palette, std::uint16_t const* data, std::size_t count)
+{
+	if(palette.size < 2)
+		return;
+
+	std::uint32_t counts[MAX_PALETTE_SIZE] = {};
+	countPaletteEntries(palette, data, count, counts);
+	sortPaletteByCounts(palette, counts);
+}
+
+inline
+Palette createPalette(std::uint16_t const* data, std::size_t count, bool vectorized, PaletteOrder order)
+{
+	auto palette = createPalette(data, count, vectorized);
+
+	if(order == PaletteOrder::frequency)
+		sortPaletteByFrequency(palette, data, count);
+
 	return palette;
 }
 
@@ -139,22 +287,42 @@ void palettizeVectorized(Palette const& palette, std::uint16_t const* in, std::s
 inline
 void palettize(Palette const& palette, std::uint16_t const* in, std::size_t count, std::uint16_t* out, bool vectorize)
 {
-	if(vectorize && palette.size <= 64)
+	if(vectorize && palette.size <= VECTORIZED_PALETTE_SIZE)
 		return palettizeVectorized(palette, in, count, out);
 
-	auto begin = palette.values;
-	auto end = begin + palette.size;
+	auto indices = paletteIndexTable();
+	fillPaletteIndexTable(palette, indices);
 
 	for(std::size_t i = 0; i != count;)
 	{
 		auto value = in[i];
-
-		auto it = std::find(begin, end, value);
-		assert(it != end);
-
-		auto index = it - begin;
+		auto index = indices[value];
 
 		do out[i++] = index;
 		while(i != count && in[i] == value);
 	}
 }
+
+inline
+void depalettize(Palette const& palette, std::uint16_t const* in, std::size_t count, std::uint16_t* out)
+{
+	for(std::size_t i = 0; i != count; ++i)
+		out[i] = palette.values[in[i]];
+}
+
+// serialized palette layout: 16-bit entry count followed by the 16-bit entries
+inline
+std::size_t writePalette(Palette const& palette, std::uint8_t* out)
+{
+	std::memcpy(out, &palette.size, sizeof palette.size);
+	std::memcpy(out + sizeof palette.size, palette.values, palette.size * sizeof *palette.values);
+	return sizeof palette.size + palette.size * sizeof *palette.values;
+}
+
+inline
+std::size_t readPalette(std::uint8_t const* in, Palette* out)
+{
+	std::memcpy(&out->size, in, sizeof out->size);
+	std::memcpy(out->values, in + sizeof out->size, out->size * sizeof *out->values);
+	return sizeof out->size + out->size * sizeof *out->values;
+}
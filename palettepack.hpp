@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bitpacking.hpp"
+#include "blockorder.hpp"
+#include "palette.hpp"
+#include "parser.hpp"
+
+// palette with its 16-bit size prefix plus the indices packed with 12 bits, which never take more than 2 bytes per block
+constexpr std::size_t MAX_ENCODED_SECTION_SIZE = sizeof(std::uint16_t) * (1 + MAX_PALETTE_SIZE) + 2 * BLOCKS_PER_SECTION;
+
+// single pass equivalent of palettize followed by bitpack16toN, without the intermediate index buffer
+// the output format is identical: 64 / Bits indices per little endian 64-bit word, which for widths dividing 8
+// is the same as the byte-wise layout of bitpack16to1/2/4/8
+template <int Bits>
+std::size_t palettizeAndPack(Palette const& palette, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	constexpr std::size_t valuesPerWord = 64 / Bits;
+
+	// multiplying an index by this repeats it in every slot of a word
+	constexpr std::uint64_t repeatFactor = []
+	{
+		std::uint64_t factor = 0;
+
+		for(std::size_t j = 0; j != valuesPerWord; ++j)
+			factor |= 1ull << (j * Bits);
+
+		return factor;
+	}();
+
+	auto indices = paletteIndexTable();
+	fillPaletteIndexTable(palette, indices);
+
+	auto loopCount = count / valuesPerWord;
+	auto remainingCount = count % valuesPerWord;
+
+	for(std::size_t i = 0; i != loopCount; ++i)
+	{
+		auto block = in + valuesPerWord * i;
+
+		// most words lie entirely within a run of the same block, the check is branchless so it gets vectorized
+		bool uniform = true;
+
+		for(std::size_t j = 1; j != valuesPerWord; ++j)
+			uniform &= block[j] == block[0];
+
+		std::uint64_t word = 0;
+
+		if(uniform)
+			word = indices[block[0]] * repeatFactor;
+		else
+		{
+			for(std::size_t j = 0; j != valuesPerWord; ++j)
+				word |= (std::uint64_t)indices[block[j]] << (j * Bits);
+		}
+
+		std::memcpy(out + 8 * i, &word, sizeof word);
+	}
+
+	if(remainingCount == 0)
+		return loopCount * 8;
+
+	std::uint64_t final = 0;
+
+	for(std::size_t j = 0; j != remainingCount; ++j)
+		final |= (std::uint64_t)indices[in[valuesPerWord * loopCount + j]] << (j * Bits);
+
+	// widths dividing 8 end on a byte boundary, the others always store a whole word
+	auto finalSize = 8 % Bits == 0 ? (remainingCount * Bits + 7) / 8 : sizeof final;
+	std::memcpy(out + 8 * loopCount, &final, finalSize);
+	return loopCount * 8 + finalSize;
+}
+
+inline
+std::size_t palettizeAndPackVanilla(Palette const& palette, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	switch(ceillog2(palette.size))
+	{
+	case 0: case 1: case 2: case 3: case 4:
+		return palettizeAndPack<4>(palette, in, count, out);
+
+	case 5: return palettizeAndPack<5>(palette, in, count, out);
+	case 6: return palettizeAndPack<6>(palette, in, count, out);
+	case 7: return palettizeAndPack<7>(palette, in, count, out);
+	case 8: return palettizeAndPack<8>(palette, in, count, out);
+	case 9: return palettizeAndPack<9>(palette, in, count, out);
+	case 10: return palettizeAndPack<10>(palette, in, count, out);
+	case 11: return palettizeAndPack<11>(palette, in, count, out);
+	case 12: return palettizeAndPack<12>(palette, in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+inline
+std::size_t palettizeAndPackOptimized(Palette const& palette, std::uint16_t const* in, std::size_t count, std::uint8_t* out)
+{
+	switch(ceillog2(palette.size))
+	{
+	// if there is only a single distinct value, we don't need to store anything
+	case 0: return 0;
+
+	case 1: return palettizeAndPack<1>(palette, in, count, out);
+	case 2: return palettizeAndPack<2>(palette, in, count, out);
+	case 3: return palettizeAndPack<3>(palette, in, count, out);
+	case 4: return palettizeAndPack<4>(palette, in, count, out);
+	case 5: return palettizeAndPack<5>(palette, in, count, out);
+	case 6: return palettizeAndPack<6>(palette, in, count, out);
+	case 7: return palettizeAndPack<7>(palette, in, count, out);
+	case 8: return palettizeAndPack<8>(palette, in, count, out);
+	case 9: return palettizeAndPack<9>(palette, in, count, out);
+	case 10: return palettizeAndPack<10>(palette, in, count, out);
+	case 11: return palettizeAndPack<11>(palette, in, count, out);
+	case 12: return palettizeAndPack<12>(palette, in, count, out);
+
+	default: break;
+	}
+
+	// palettes never have more than 4096 entries, which take 12 bits
+	assert(false);
+	__builtin_unreachable();
+}
+
+// size of count indices packed by palettizeAndPackOptimized for a palette of the given bit depth
+constexpr std::size_t packedSize(int bits, std::size_t count)
+{
+	if(bits == 0)
+		return 0;
+
+	auto valuesPerWord = 64 / bits;
+	auto remainingCount = count % valuesPerWord;
+	auto size = count / valuesPerWord * 8;
+
+	if(remainingCount == 0)
+		return size;
+
+	return size + (8 % bits == 0 ? (remainingCount * bits + 7) / 8 : 8);
+}
+
+// a section as the palette followed by the indices packed with bitpackOptimized widths, returns the encoded size
+// the indices are packed in the given block order, the palette doesn't depend on it
+inline
+std::size_t encodeSection(std::uint16_t const* data, std::uint8_t* out, PaletteOrder order = PaletteOrder::firstSeen,
+                          BlockOrder blockOrder = BlockOrder::linear)
+{
+	auto palette = createPalette(data, BLOCKS_PER_SECTION, false, order);
+	auto size = writePalette(palette, out);
+
+	// palettizing commutes with the reordering, so the fused kernel can run on the reordered blocks
+	std::uint16_t buf[BLOCKS_PER_SECTION];
+	auto blocks = reorderBlocks(data, blockOrder, buf);
+
+	return size + palettizeAndPackOptimized(palette, blocks, BLOCKS_PER_SECTION, out + size);
+}
+
+// inverse of encodeSection, returns the number of bytes consumed
+inline
+std::size_t decodeSection(std::uint8_t const* in, std::uint16_t* out, BlockOrder blockOrder = BlockOrder::linear)
+{
+	Palette palette;
+	auto size = readPalette(in, &palette);
+
+	std::uint16_t buf[BLOCKS_PER_SECTION];
+	size += bitunpackOptimized(palette.size, in + size, BLOCKS_PER_SECTION, buf);
+
+	if(blockOrder != BlockOrder::linear)
+	{
+		std::uint16_t indices[BLOCKS_PER_SECTION];
+		restoreBlocks(buf, blockOrder, indices);
+		depalettize(palette, indices, BLOCKS_PER_SECTION, out);
+		return size;
+	}
+
+	depalettize(palette, buf, BLOCKS_PER_SECTION, out);
+	return size;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// a trade-off between two quantities that are both better when larger, e.g. compression ratio and speed
+struct ParetoPoint
+{
+	double x;
+	double y;
+};
+
+// whether a is at least as good as b in both quantities and better in one of them
+inline
+bool dominates(ParetoPoint const& a, ParetoPoint const& b)
+{
+	return a.x >= b.x && a.y >= b.y && (a.x > b.x || a.y > b.y);
+}
+
+// indices of the points no other point dominates, in order of increasing x
+// of several identical points, only the first is kept
+inline
+std::vector<std::size_t> paretoFrontier(std::vector<ParetoPoint> const& points)
+{
+	std::vector<std::size_t> order(points.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	// by decreasing x, then decreasing y, so every point only has to beat the best y seen so far
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+	{
+		return points[a].x != points[b].x ? points[a].x > points[b].x : points[a].y > points[b].y;
+	});
+
+	std::vector<std::size_t> frontier;
+
+	for(auto i : order)
+	{
+		if(frontier.empty() || points[i].y > points[frontier.back()].y)
+			frontier.push_back(i);
+	}
+
+	std::reverse(frontier.begin(), frontier.end());
+	return frontier;
+}
+
+inline
+ParetoPoint compressionPoint(BenchmarkResult const& result)
+{
+	return {result.size == 0 ? 0. : (double)result.inputSize / result.size, result.time == 0 ? 0. : result.inputSize / 1024. / 1024. / result.time};
+}
+
+// lists the points by x, with the ones on the frontier marked and the others attributed to the point with the
+// largest y of those that beat them in both
+inline
+void printParetoFrontier(std::vector<std::string> const& names, std::vector<ParetoPoint> const& points, char const* title)
+{
+	if(points.size() < 2)
+		return;
+
+	std::vector<bool> onFrontier(points.size());
+
+	for(auto i : paretoFrontier(points))
+		onFrontier[i] = true;
+
+	std::vector<std::size_t> order(points.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return points[a].x < points[b].x; });
+
+	std::printf("%s pareto frontier:\n", title);
+
+	for(auto i : order)
+	{
+		std::printf("\t%s: ratio %.2f, speed %.2f MiB/s", names[i].c_str(), points[i].x, points[i].y);
+
+		if(onFrontier[i])
+		{
+			std::printf(", pareto optimal\n");
+			continue;
+		}
+
+		std::size_t best = i;
+
+		for(std::size_t j = 0; j != points.size(); ++j)
+		{
+			if(dominates(points[j], points[i]) && (best == i || points[j].y > points[best].y))
+				best = j;
+		}
+
+		// identical points don't dominate each other, only the first of them is on the frontier
+		std::printf(", dominated by %s\n", best == i ? "an identical result" : names[best].c_str());
+	}
+
+	std::printf("\n");
+}
+
+// the ratio/speed frontier of the single threaded results
+inline
+void printParetoFrontier(std::vector<BenchmarkResult> const& results)
+{
+	std::vector<std::string> names;
+	std::vector<ParetoPoint> points;
+
+	for(auto& result : results)
+	{
+		if(result.threads != 1)
+			continue;
+
+		names.push_back(result.scheme);
+		points.push_back(compressionPoint(result));
+	}
+
+	printParetoFrontier(names, points, "ratio/speed");
+}
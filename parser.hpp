@@ -2,52 +2,154 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <optional>
+#include <vector>
 
 constexpr std::size_t BLOCKS_PER_SECTION = 16 * 16 * 16;
 constexpr std::size_t SECTIONS_PER_CHUNK = 16;
 constexpr std::size_t CHUNKS_PER_REGION = 32 * 32;
 
+struct SectionRange
+{
+	std::uint16_t const* const* first;
+	std::uint16_t const* const* last;
+
+	std::uint16_t const* const* begin() const
+	{
+		return first;
+	}
+
+	std::uint16_t const* const* end() const
+	{
+		return last;
+	}
+
+	std::size_t size() const
+	{
+		return last - first;
+	}
+};
+
+// a chunk that is present in its region, only its present sections are listed, in ascending y order
 struct Chunk
 {
-	std::optional<std::uint16_t const*> sections[SECTIONS_PER_CHUNK];
+	// points into the section array of the owning region
+	std::uint16_t const* const* firstSection = nullptr;
+	std::uint16_t sectionCount = 0;
+	// bit y is set if the section at height y is present
+	std::uint16_t sectionMask = 0;
+	// position within the region, x + 32 * z, for chunks of samples that of the region they were taken from
+	std::uint16_t index = 0;
+
+	SectionRange sections() const
+	{
+		return {firstSection, firstSection + sectionCount};
+	}
+
+	int x() const
+	{
+		return index % 32;
+	}
+
+	int z() const
+	{
+		return index / 32;
+	}
 };
 
+// the present chunks of a region, with the section pointers of all of them in one contiguous array
 struct Region
 {
-	std::optional<Chunk> chunks[CHUNKS_PER_REGION];
+	int x = 0;
+	int z = 0;
+	std::vector<std::uint16_t const*> sections;
+	std::vector<Chunk> chunks;
+
+	Region() = default;
+	Region(Region&&) = default;
+	Region& operator=(Region&&) = default;
+
+	Region(Region const& other)
+	: x(other.x)
+	, z(other.z)
+	, sections(other.sections)
+	, chunks(other.chunks)
+	{
+		relink();
+	}
+
+	Region& operator=(Region const& other)
+	{
+		x = other.x;
+		z = other.z;
+		sections = other.sections;
+		chunks = other.chunks;
+		relink();
+		return *this;
+	}
+
+	void addChunk(std::uint16_t index, std::uint16_t sectionMask, std::uint16_t const* const* chunkSections)
+	{
+		auto data = sections.data();
+		std::uint16_t count = __builtin_popcount(sectionMask);
+
+		sections.insert(sections.end(), chunkSections, chunkSections + count);
+		chunks.push_back({sections.data() + sections.size() - count, count, sectionMask, index});
+
+		if(sections.data() != data)
+			relink();
+	}
+
+private:
+	// the chunks section pointers have to follow the section array whenever it moves
+	void relink()
+	{
+		auto section = sections.data();
+
+		for(auto& chunk : chunks)
+		{
+			chunk.firstSection = section;
+			section += chunk.sectionCount;
+		}
+	}
 };
 
 inline
-Chunk parseChunk(std::uint16_t*& data)
+void parseChunk(std::uint16_t const*& data, std::uint16_t index, Region& region)
 {
 	auto bitmask = *data++;
-	Chunk chunk;
+	std::uint16_t const* sections[SECTIONS_PER_CHUNK];
+	std::size_t count = 0;
 
 	for(auto i = 0; i != SECTIONS_PER_CHUNK; ++i)
 	{
 		if(bitmask & (1 << i))
 		{
-			chunk.sections[i] = data;
+			sections[count++] = data;
 			data += BLOCKS_PER_SECTION;
 		}
 	}
 
-	return chunk;
+	region.addChunk(index, bitmask, sections);
 }
 
 inline
 Region parseRegion(std::uint8_t const* data)
 {
 	Region region;
+	std::size_t chunkCount = 0;
+
+	for(std::size_t i = 0; i != CHUNKS_PER_REGION / 8; ++i)
+		chunkCount += __builtin_popcount(data[i]);
+
+	region.chunks.reserve(chunkCount);
 
 	// skip chunk bitmap
-	auto chunkPtr = data + CHUNKS_PER_REGION / 8;
+	auto chunkPtr = (std::uint16_t const*)(data + CHUNKS_PER_REGION / 8);
 
 	for(auto i = 0; i != CHUNKS_PER_REGION; ++i)
 	{
 		if(data[i / 8] & (1 << (i % 8)))
-			region.chunks[i] = parseChunk(*(std::uint16_t**)&chunkPtr);
+			parseChunk(chunkPtr, i, region);
 	}
 
 	return region;
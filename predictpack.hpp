@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bitpacking.hpp"
+#include "palette.hpp"
+#include "palettepack.hpp"
+#include "parser.hpp"
+
+// how a section is stored relative to its predictor, named by the first byte of the encoded section
+enum PredictionMode : std::uint8_t
+{
+	// the encodeSection format, without using the predictor
+	PREDICTION_NONE,
+	// every block is the same as in the predictor, nothing else is stored
+	PREDICTION_SAME,
+	// a bit per block that differs from the predictor, then the differing blocks in storage order as a palette and
+	// their packed indices
+	PREDICTION_EXCEPTIONS,
+};
+
+constexpr std::size_t PREDICTION_MASK_SIZE = BLOCKS_PER_SECTION / 8;
+
+// the encoding without prediction is always available, so no section ever takes more than that
+constexpr std::size_t MAX_PREDICTED_SECTION_SIZE = 1 + MAX_ENCODED_SECTION_SIZE;
+
+// a section coded against the blocks at the same positions of the predictor section, or on its own if that's
+// smaller, returns the encoded size
+// a null predictor always stores the section on its own
+inline
+std::size_t encodeSectionPredicted(std::uint16_t const* data, std::uint16_t const* predictor, std::uint8_t* out,
+                                   PaletteOrder order = PaletteOrder::firstSeen)
+{
+	if(!predictor)
+	{
+		out[0] = PREDICTION_NONE;
+		return 1 + encodeSection(data, out + 1, order);
+	}
+
+	std::uint64_t mask[PREDICTION_MASK_SIZE / sizeof(std::uint64_t)];
+	std::uint16_t exceptions[BLOCKS_PER_SECTION];
+	std::size_t exceptionCount = 0;
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; i += 64)
+	{
+		std::uint64_t word = 0;
+
+		// branchless, so the comparisons get vectorized
+		for(std::size_t j = 0; j != 64; ++j)
+			word |= (std::uint64_t)(data[i + j] != predictor[i + j]) << j;
+
+		mask[i / 64] = word;
+
+		for(auto bits = word; bits; bits &= bits - 1)
+			exceptions[exceptionCount++] = data[i + __builtin_ctzll(bits)];
+	}
+
+	if(exceptionCount == 0)
+	{
+		out[0] = PREDICTION_SAME;
+		return 1;
+	}
+
+	auto palette = createPalette(data, BLOCKS_PER_SECTION, false, order);
+	auto exceptionPalette = createPalette(exceptions, exceptionCount, false, order);
+
+	auto ownSize = sizeof palette.size + palette.size * sizeof *palette.values
+	               + packedSize(ceillog2(palette.size), BLOCKS_PER_SECTION);
+	auto predictedSize = PREDICTION_MASK_SIZE + sizeof exceptionPalette.size + exceptionPalette.size * sizeof *exceptionPalette.values
+	                     + packedSize(ceillog2(exceptionPalette.size), exceptionCount);
+
+	// the encoded sizes ignore how well the compressor does on either, mostly uniform packed indices shrink to about
+	// what the blocks other than the most common one take, so prediction also has to leave fewer of those
+	std::uint32_t counts[MAX_PALETTE_SIZE] = {};
+	countPaletteEntries(palette, data, BLOCKS_PER_SECTION, counts);
+	auto otherBlocks = BLOCKS_PER_SECTION - *std::max_element(counts, counts + palette.size);
+
+	if(ownSize <= predictedSize || otherBlocks <= exceptionCount)
+	{
+		out[0] = PREDICTION_NONE;
+		auto size = writePalette(palette, out + 1);
+		return 1 + size + palettizeAndPackOptimized(palette, data, BLOCKS_PER_SECTION, out + 1 + size);
+	}
+
+	out[0] = PREDICTION_EXCEPTIONS;
+	auto p = out + 1;
+	std::memcpy(p, mask, sizeof mask);
+	p += sizeof mask;
+	p += writePalette(exceptionPalette, p);
+	p += palettizeAndPackOptimized(exceptionPalette, exceptions, exceptionCount, p);
+	return p - out;
+}
+
+// inverse of encodeSectionPredicted with the same predictor, returns the number of bytes consumed
+inline
+std::size_t decodeSectionPredicted(std::uint8_t const* in, std::uint16_t const* predictor, std::uint16_t* out)
+{
+	if(in[0] == PREDICTION_NONE)
+		return 1 + decodeSection(in + 1, out);
+
+	std::copy(predictor, predictor + BLOCKS_PER_SECTION, out);
+
+	if(in[0] == PREDICTION_SAME)
+		return 1;
+
+	std::uint64_t mask[PREDICTION_MASK_SIZE / sizeof(std::uint64_t)];
+	auto p = in + 1;
+	std::memcpy(mask, p, sizeof mask);
+	p += sizeof mask;
+
+	std::size_t exceptionCount = 0;
+
+	for(auto word : mask)
+		exceptionCount += __builtin_popcountll(word);
+
+	Palette palette;
+	p += readPalette(p, &palette);
+
+	// the kernels for widths dividing 8 only unpack whole bytes, the packed indices always end on one
+	auto bits = ceillog2(palette.size);
+	auto unpackCount = bits != 0 && 8 % bits == 0 ? (exceptionCount + 7) / 8 * 8 : exceptionCount;
+
+	std::uint16_t indices[BLOCKS_PER_SECTION];
+	bitunpackOptimized(palette.size, p, unpackCount, indices);
+	p += packedSize(bits, exceptionCount);
+
+	std::uint16_t exceptions[BLOCKS_PER_SECTION];
+	depalettize(palette, indices, exceptionCount, exceptions);
+
+	std::size_t exception = 0;
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; i += 64)
+		for(auto word = mask[i / 64]; word; word &= word - 1)
+			out[i + __builtin_ctzll(word)] = exceptions[exception++];
+
+	return p - in;
+}
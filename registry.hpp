@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "blockorder.hpp"
+#include "compressors/brotli.hpp"
+#include "compressors/bzip2.hpp"
+#include "compressors/libdeflate.hpp"
+#include "compressors/lz4.hpp"
+#include "compressors/null.hpp"
+#include "compressors/zlib.hpp"
+#include "compressors/zstd.hpp"
+#include "compressors/zstddict.hpp"
+#include "loader.hpp"
+#include "schemes/adaptive.hpp"
+#include "schemes/opt1.hpp"
+#include "schemes/opt2.hpp"
+#include "schemes/predictive.hpp"
+#include "schemes/region.hpp"
+#include "schemes/rle.hpp"
+#include "schemes/shared.hpp"
+#include "schemes/vanilla.hpp"
+#include "sweep.hpp"
+
+// settings of the schemes that aren't covered by the compressor level
+struct SchemeParameters
+{
+	std::size_t chunksPerFrame = 16;
+	PaletteOrder paletteOrder = PaletteOrder::firstSeen;
+	// vanilla and opt1 reproduce existing formats and always pack blocks in linear order, and so does predictive
+	BlockOrder blockOrder = BlockOrder::linear;
+	// only called when a configuration needs the dictionary, since training it takes a while
+	// null if the world is too small to train one
+	std::function<ZstdDictionary()> dictionary;
+};
+
+// the schemes that take a compressor, by name
+template <typename Compressor, typename... P>
+Configuration makeCompressorConfiguration(std::string const& scheme, SchemeParameters const& parameters, P... p)
+{
+	if(scheme == "opt2")
+		return makeConfiguration<Opt2CompressionScheme<Compressor>>(parameters.paletteOrder, parameters.blockOrder, p...);
+
+	if(scheme == "region")
+		return makeConfiguration<RegionCompressionScheme<Compressor>>(parameters.chunksPerFrame, parameters.paletteOrder, parameters.blockOrder, p...);
+
+	if(scheme == "rle")
+		return makeConfiguration<RleCompressionScheme<Compressor>>(parameters.paletteOrder, parameters.blockOrder, p...);
+
+	if(scheme == "predictive")
+		return makeConfiguration<PredictiveCompressionScheme<Compressor>>(parameters.paletteOrder, p...);
+
+	if(scheme == "shared")
+		return makeConfiguration<SharedPaletteCompressionScheme<Compressor>>(parameters.paletteOrder, parameters.blockOrder, p...);
+
+	fatalError("scheme '%s' doesn't take a compressor\n", scheme.c_str());
+}
+
+struct CompressorEntry
+{
+	char const* name;
+	int minLevel;
+	int maxLevel;
+	// the levels a run without --levels covers, empty if minLevel > maxLevel
+	int defaultMinLevel;
+	int defaultMaxLevel;
+	Configuration (*configure)(std::string const& scheme, int level, SchemeParameters const& parameters);
+};
+
+inline
+std::vector<CompressorEntry> const& compressorRegistry()
+{
+	using P = SchemeParameters const&;
+
+	static std::vector<CompressorEntry> const registry =
+	{
+		{"null", 0, 0, 0, 0, [](std::string const& s, int, P p) { return makeCompressorConfiguration<NullCompressor>(s, p); }},
+		{"brotli", 0, 11, 0, 8, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<BrotliCompressor>(s, p, l); }},
+		{"zlib", 0, 9, 1, 8, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<ZlibCompressor>(s, p, l); }},
+		{"libdeflate", 0, 12, 1, 9, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<LibDeflateCompressor>(s, p, l); }},
+		{"zstd", 0, 22, 0, 12, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<ZstdCompressor>(s, p, l); }},
+		{"zstd-dict", 0, 22, 0, 12, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<ZstdDictCompressor>(s, p, l, p.dictionary()); }},
+		// the level is lz4's acceleration factor, where 0 means the default
+		{"lz4", 0, 65537, 0, 0, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<Lz4Compressor>(s, p, l); }},
+		// the level is bzip2's work factor, slow enough to be left out by default
+		{"bzip2", 0, 250, 1, 0, [](std::string const& s, int l, P p) { return makeCompressorConfiguration<Bzip2Compressor>(s, p, l); }},
+	};
+
+	return registry;
+}
+
+inline
+CompressorEntry const& findCompressor(std::string const& name)
+{
+	for(auto& entry : compressorRegistry())
+		if(name == entry.name)
+			return entry;
+
+	std::string names;
+
+	for(auto& entry : compressorRegistry())
+		names += std::string(names.empty() ? "" : ", ") + entry.name;
+
+	fatalError("unknown compressor '%s', expected one of %s\n", name.c_str(), names.c_str());
+}
+
+inline
+BlockOrder parseBlockOrder(std::string const& text)
+{
+	for(auto order : {BlockOrder::linear, BlockOrder::morton, BlockOrder::hilbert})
+		if(text == blockOrderName(order))
+			return order;
+
+	fatalError("invalid block order '%s', expected linear, morton or hilbert\n", text.c_str());
+}
+
+// parses comma separated levels and ranges with an optional step, e.g. "1-9", "1,3,9" or "1-250:10"
+inline
+std::vector<int> parseLevels(std::string const& text)
+{
+	std::vector<int> levels;
+	std::size_t start = 0;
+
+	while(start <= text.size())
+	{
+		auto end = std::min(text.find(',', start), text.size());
+		auto item = text.substr(start, end - start);
+		char* p;
+
+		auto first = (int)std::strtol(item.c_str(), &p, 10);
+		auto last = first;
+		auto step = 1;
+
+		if(p == item.c_str())
+			fatalError("invalid levels '%s'\n", text.c_str());
+
+		if(*p == '-')
+			last = (int)std::strtol(p + 1, &p, 10);
+
+		if(*p == ':')
+			step = (int)std::strtol(p + 1, &p, 10);
+
+		if(*p != '\0' || step <= 0 || last < first)
+			fatalError("invalid levels '%s'\n", text.c_str());
+
+		for(auto level = first; level <= last; level += step)
+			levels.push_back(level);
+
+		start = end + 1;
+	}
+
+	return levels;
+}
+
+// the configurations of a scheme and a compressor, an empty compressor selects all of them
+// without levels, every compressor runs its default levels, otherwise those of the given levels it supports
+inline
+std::vector<Configuration> makeConfigurations(std::string const& scheme, std::string const& compressor, std::vector<int> levels,
+                                              SchemeParameters const& parameters)
+{
+	if(scheme == "vanilla" || scheme == "opt1")
+	{
+		if(!compressor.empty() || !levels.empty())
+			fatalError("scheme '%s' always uses zlib and takes no compressor or levels\n", scheme.c_str());
+
+		if(scheme == "vanilla")
+			return {makeConfiguration<VanillaCompressionScheme>(parameters.paletteOrder)};
+
+		return {makeConfiguration<Opt1CompressionScheme>(parameters.paletteOrder)};
+	}
+
+	// adaptive picks its own compressors per chunk, the levels select its high zstd level
+	if(scheme == "adaptive")
+	{
+		if(!compressor.empty())
+			fatalError("scheme 'adaptive' picks its compressors itself and takes no compressor\n");
+
+		std::vector<Configuration> configurations;
+
+		for(auto level : levels.empty() ? std::vector<int>{9} : levels)
+		{
+			if(level < 1 || level > 22)
+				fatalError("level %d is out of range for adaptive, which supports 1-22\n", level);
+
+			for(auto policy : {AdaptivePolicy::heuristic, AdaptivePolicy::trial})
+				configurations.push_back(makeConfiguration<AdaptiveCompressionScheme>(policy, 1, level, parameters.paletteOrder, parameters.blockOrder));
+		}
+
+		return configurations;
+	}
+
+	if(scheme != "opt2" && scheme != "region" && scheme != "rle" && scheme != "shared" && scheme != "predictive")
+		fatalError("unknown scheme '%s', expected one of vanilla, opt1, opt2, region, adaptive, rle, shared, predictive\n", scheme.c_str());
+
+	std::vector<CompressorEntry const*> entries;
+
+	if(compressor.empty())
+	{
+		for(auto& entry : compressorRegistry())
+			entries.push_back(&entry);
+	}
+	else
+		entries.push_back(&findCompressor(compressor));
+
+	std::vector<Configuration> configurations;
+
+	for(auto entry : entries)
+	{
+		// without a dictionary, the configurations using it are left out and the others still run
+		if(entry->name == std::string("zstd-dict") && !parameters.dictionary())
+		{
+			std::printf("skipping %s:%s, there is no zstd dictionary\n", scheme.c_str(), entry->name);
+			continue;
+		}
+
+		auto entryLevels = levels;
+
+		if(entryLevels.empty())
+		{
+			for(auto level = entry->defaultMinLevel; level <= entry->defaultMaxLevel; ++level)
+				entryLevels.push_back(level);
+		}
+
+		for(auto level : entryLevels)
+		{
+			if(level >= entry->minLevel && level <= entry->maxLevel)
+				configurations.push_back(entry->configure(scheme, level, parameters));
+			else if(!compressor.empty())
+				fatalError("level %d is out of range for %s, which supports %d-%d\n", level, entry->name, entry->minLevel, entry->maxLevel);
+		}
+	}
+
+	return configurations;
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "benchmark.hpp"
+#include "loader.hpp"
+
+// set by the build to the flags the benchmark was compiled with
+#ifndef COMPILER_FLAGS
+#define COMPILER_FLAGS ""
+#endif
+
+// describes the machine and build a result file was produced on, so files from different runs can be told apart
+struct RunMetadata
+{
+	std::string cpu;
+	std::string compiler;
+	std::string flags;
+	std::string host;
+	std::string timestamp;
+};
+
+inline
+RunMetadata collectMetadata()
+{
+	RunMetadata metadata;
+	metadata.cpu = "unknown";
+
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	std::string line;
+
+	while(std::getline(cpuinfo, line))
+	{
+		if(line.compare(0, 10, "model name") != 0)
+			continue;
+
+		auto colon = line.find(':');
+
+		if(colon != std::string::npos)
+			metadata.cpu = line.substr(line.find_first_not_of(' ', colon + 1));
+
+		break;
+	}
+
+#ifdef __clang__
+	metadata.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	metadata.compiler = "gcc " __VERSION__;
+#else
+	metadata.compiler = "unknown";
+#endif
+
+	metadata.flags = COMPILER_FLAGS;
+
+	char host[256] = {};
+	gethostname(host, sizeof host - 1);
+	metadata.host = host;
+
+	char timestamp[32];
+	auto now = std::time(nullptr);
+	std::strftime(timestamp, sizeof timestamp, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+	metadata.timestamp = timestamp;
+
+	return metadata;
+}
+
+// one field of a result record, numbers are written without quotes in json
+struct ResultField
+{
+	std::string key;
+	std::string value;
+	bool numeric;
+};
+
+using ResultRecord = std::vector<ResultField>;
+
+// collects one record per benchmark run and writes them as csv or json, depending on the file extension
+class ResultWriter
+{
+	RunMetadata _metadata;
+	std::vector<ResultRecord> _records;
+	std::vector<BenchmarkResult> _results;
+
+	static std::string number(double value)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof buffer, "%.6g", value);
+		return buffer;
+	}
+
+	static std::string quoted(std::string const& value, char escape)
+	{
+		std::string result = "\"";
+
+		for(auto c : value)
+		{
+			if(c == '"' || (escape == '\\' && c == '\\'))
+				result += escape;
+
+			result += c;
+		}
+
+		return result + "\"";
+	}
+
+public:
+	ResultWriter()
+	: _metadata(collectMetadata())
+	{}
+
+	// mode tells runs over the same scheme apart, e.g. full encoding versus compressing cached payloads
+	void add(BenchmarkResult const& result, char const* mode)
+	{
+		// scheme names look like opt2:zstd/3, the compressor and level parts are optional
+		auto colon = result.scheme.find(':');
+		auto scheme = result.scheme.substr(0, colon);
+		auto compressor = colon == std::string::npos ? std::string() : result.scheme.substr(colon + 1);
+		auto slash = compressor.find('/');
+		auto level = slash == std::string::npos ? std::string() : compressor.substr(slash + 1);
+		compressor = compressor.substr(0, slash);
+
+		auto mib = result.inputSize / 1024. / 1024.;
+
+		_results.push_back(result);
+		_records.push_back({
+			{"name", result.scheme, false},
+			{"scheme", scheme, false},
+			{"compressor", compressor, false},
+			{"level", level, false},
+			{"mode", mode, false},
+			{"threads", std::to_string(result.threads), true},
+			{"input_bytes", std::to_string(result.inputSize), true},
+			{"output_bytes", std::to_string(result.size), true},
+			{"ratio", number(result.size == 0 ? 0 : (double)result.inputSize / result.size), true},
+			{"wall_seconds", number(result.time), true},
+			{"cpu_seconds", number(result.cpuTime), true},
+			{"mib_per_second", number(result.time == 0 ? 0 : mib / result.time), true},
+			{"repetitions", std::to_string(std::max<std::size_t>(result.timeStatistics.count, 1)), true},
+			{"wall_mean_seconds", number(result.timeStatistics.count ? result.timeStatistics.mean : result.time), true},
+			{"wall_stddev_seconds", number(result.timeStatistics.stddev), true},
+			{"wall_ci95_seconds", number(result.timeStatistics.confidence), true},
+			{"output_bytes_error", number(result.sizeError), true},
+			{"wall_seconds_error", number(result.timeError), true},
+			{"allocations_per_chunk", number(result.chunkCount == 0 ? 0 : (double)result.allocations / result.chunkCount), true},
+			{"allocated_bytes_per_chunk", number(result.chunkCount == 0 ? 0 : (double)result.allocatedBytes / result.chunkCount), true},
+			{"cpu", _metadata.cpu, false},
+			{"compiler", _metadata.compiler, false},
+			{"flags", _metadata.flags, false},
+			{"host", _metadata.host, false},
+			{"timestamp", _metadata.timestamp, false},
+		});
+	}
+
+	std::vector<BenchmarkResult> const& results() const
+	{
+		return _results;
+	}
+
+	void write(fs::path const& path) const
+	{
+		std::ofstream out(path);
+
+		if(!out)
+			fatalError("failed to open '%s' for writing\n", path.string().c_str());
+
+		if(path.extension() == ".json")
+		{
+			out << "[\n";
+
+			for(std::size_t i = 0; i != _records.size(); ++i)
+			{
+				out << "\t{";
+
+				for(std::size_t j = 0; j != _records[i].size(); ++j)
+				{
+					auto& field = _records[i][j];
+					out << (j == 0 ? "" : ", ") << quoted(field.key, '\\') << ": " << (field.numeric ? field.value : quoted(field.value, '\\'));
+				}
+
+				out << (i + 1 == _records.size() ? "}\n" : "},\n");
+			}
+
+			out << "]\n";
+		}
+		else
+		{
+			for(std::size_t j = 0; !_records.empty() && j != _records[0].size(); ++j)
+				out << (j == 0 ? "" : ",") << _records[0][j].key;
+
+			out << "\n";
+
+			for(auto& record : _records)
+			{
+				for(std::size_t j = 0; j != record.size(); ++j)
+					out << (j == 0 ? "" : ",") << (record[j].numeric ? record[j].value : quoted(record[j].value, '"'));
+
+				out << "\n";
+			}
+		}
+	}
+};
+
+// reads back a file written by ResultWriter, every record as a map from field names to their text
+// this only understands the subset of csv and json that ResultWriter produces
+inline
+std::vector<std::map<std::string, std::string>> readResults(fs::path const& path)
+{
+	std::ifstream in(path);
+
+	if(!in)
+		fatalError("failed to open '%s'\n", path.string().c_str());
+
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	auto text = buffer.str();
+	std::size_t i = 0;
+
+	auto skipSpace = [&]
+	{
+		while(i < text.size() && std::isspace((unsigned char)text[i]))
+			++i;
+	};
+
+	// a quoted string with the given escape character, or a bare token up to one of the terminators
+	auto value = [&](char escape, char const* terminators)
+	{
+		std::string result;
+
+		if(i >= text.size() || text[i] != '"')
+		{
+			while(i < text.size() && !std::strchr(terminators, text[i]))
+				result += text[i++];
+
+			return result;
+		}
+
+		for(++i; i < text.size(); ++i)
+		{
+			if(text[i] == escape && i + 1 < text.size() && (escape != '"' || text[i + 1] == '"'))
+				result += text[++i];
+			else if(text[i] == '"')
+				break;
+			else
+				result += text[i];
+		}
+
+		++i;
+		return result;
+	};
+
+	std::vector<std::map<std::string, std::string>> records;
+
+	if(path.extension() == ".json")
+	{
+		while(i < text.size())
+		{
+			skipSpace();
+
+			if(i >= text.size() || text[i] != '{')
+			{
+				++i;
+				continue;
+			}
+
+			++i;
+			std::map<std::string, std::string> record;
+
+			for(;;)
+			{
+				skipSpace();
+
+				if(i >= text.size() || text[i] == '}')
+					break;
+
+				auto key = value('\\', ":");
+				skipSpace();
+				++i;
+				skipSpace();
+				record[key] = value('\\', ",}");
+				skipSpace();
+
+				if(i < text.size() && text[i] == ',')
+					++i;
+			}
+
+			++i;
+			records.push_back(record);
+		}
+
+		return records;
+	}
+
+	std::vector<std::string> keys;
+
+	while(i < text.size() && text[i] != '\n')
+	{
+		keys.push_back(value('"', ",\n"));
+
+		if(i < text.size() && text[i] == ',')
+			++i;
+	}
+
+	while(++i < text.size())
+	{
+		std::map<std::string, std::string> record;
+
+		for(std::size_t j = 0; j != keys.size() && i < text.size() && text[i] != '\n'; ++j)
+		{
+			record[keys[j]] = value('"', ",\n");
+
+			if(i < text.size() && text[i] == ',')
+				++i;
+		}
+
+		records.push_back(record);
+	}
+
+	return records;
+}
+
+// a numeric field of a record returned by readResults, 0 if the record doesn't have it
+inline
+double resultNumber(std::map<std::string, std::string> const& record, char const* key)
+{
+	auto it = record.find(key);
+	return it == record.end() ? 0 : std::strtod(it->second.c_str(), nullptr);
+}
+
+// relative change in percent, positive if the candidate is higher
+inline
+double relativeChange(double baseline, double candidate)
+{
+	return baseline == 0 ? 0 : 100 * (candidate - baseline) / baseline;
+}
+
+// whether the candidate run lost more than threshold percent of ratio or speed against the baseline run
+inline
+bool isRegression(std::map<std::string, std::string> const& baseline, std::map<std::string, std::string> const& candidate,
+                  double threshold)
+{
+	auto ratioChange = relativeChange(resultNumber(baseline, "ratio"), resultNumber(candidate, "ratio"));
+	auto speedChange = relativeChange(resultNumber(baseline, "mib_per_second"), resultNumber(candidate, "mib_per_second"));
+	// with repeated runs on both sides, a slowdown only counts if the confidence intervals of the times don't overlap
+	auto baseTime = resultNumber(baseline, "wall_mean_seconds");
+	auto candidateTime = resultNumber(candidate, "wall_mean_seconds");
+	auto significant = resultNumber(baseline, "repetitions") < 2 || resultNumber(candidate, "repetitions") < 2
+	                   || candidateTime - resultNumber(candidate, "wall_ci95_seconds") > baseTime + resultNumber(baseline, "wall_ci95_seconds");
+
+	return ratioChange < -threshold || (speedChange < -threshold && significant);
+}
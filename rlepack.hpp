@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bitpacking.hpp"
+#include "blockorder.hpp"
+#include "palette.hpp"
+#include "palettepack.hpp"
+#include "parser.hpp"
+
+// the encodings a section can be stored with, named by the first byte of the encoded section
+// all of them start with the palette, so the indices are stored with 1 byte for palettes of up to 256 entries and
+// 2 bytes otherwise
+enum SectionEncoding : std::uint8_t
+{
+	// the encodeSection format
+	SECTION_PACKED,
+	// run count, then every run of equal blocks in storage order (y, z, x) as its index and a varint of its length - 1
+	SECTION_RUNS,
+	// the index of the most common block, the number of other blocks, then every other block as a varint of the
+	// distance from the previous one and its index
+	SECTION_SPARSE,
+};
+
+// the packed encoding is always available, so no section ever takes more than that
+constexpr std::size_t MAX_RLE_SECTION_SIZE = 1 + MAX_ENCODED_SECTION_SIZE;
+
+// LEB128, 7 bits per byte with the high bit marking that more bytes follow
+inline
+std::size_t varintSize(std::uint32_t value)
+{
+	std::size_t size = 1;
+
+	while(value >= 0x80)
+	{
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+}
+
+inline
+std::size_t writeVarint(std::uint32_t value, std::uint8_t* out)
+{
+	std::size_t size = 0;
+
+	while(value >= 0x80)
+	{
+		out[size++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+
+	out[size++] = value;
+	return size;
+}
+
+inline
+std::size_t readVarint(std::uint8_t const* in, std::uint32_t& value)
+{
+	std::size_t size = 0;
+	value = 0;
+
+	do value |= (std::uint32_t)(in[size] & 0x7f) << (7 * size);
+	while(in[size++] & 0x80);
+
+	return size;
+}
+
+inline
+std::size_t writeIndex(std::uint16_t index, std::size_t indexSize, std::uint8_t* out)
+{
+	out[0] = index;
+
+	if(indexSize == 2)
+		out[1] = index >> 8;
+
+	return indexSize;
+}
+
+inline
+std::size_t readIndex(std::uint8_t const* in, std::size_t indexSize, std::uint16_t& index)
+{
+	index = indexSize == 2 ? in[0] | in[1] << 8 : in[0];
+	return indexSize;
+}
+
+// a section in whichever of the encodings is smallest, returns the encoded size
+// the sizes of all of them follow from a single pass over the runs of the section, only the chosen one is written
+// all encodings store the blocks in the given block order
+inline
+std::size_t encodeSectionRle(std::uint16_t const* data, std::uint8_t* out, PaletteOrder order = PaletteOrder::firstSeen,
+                             BlockOrder blockOrder = BlockOrder::linear)
+{
+	struct Run
+	{
+		std::uint16_t index;
+		std::uint16_t length;
+	};
+
+	std::uint16_t reordered[BLOCKS_PER_SECTION];
+	data = reorderBlocks(data, blockOrder, reordered);
+
+	auto palette = createPalette(data, BLOCKS_PER_SECTION, false, order);
+	auto indices = paletteIndexTable();
+	fillPaletteIndexTable(palette, indices);
+
+	Run runs[BLOCKS_PER_SECTION];
+	std::size_t runCount = 0;
+	std::size_t runsSize = 0;
+	std::uint16_t counts[MAX_PALETTE_SIZE] = {};
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION;)
+	{
+		auto value = data[i];
+		auto start = i;
+
+		do ++i;
+		while(i != BLOCKS_PER_SECTION && data[i] == value);
+
+		std::uint16_t length = i - start;
+		runs[runCount++] = {indices[value], length};
+		runsSize += varintSize(length - 1);
+		counts[indices[value]] += length;
+	}
+
+	auto indexSize = palette.size <= 256 ? 1 : 2;
+	auto paletteSize = sizeof palette.size + palette.size * sizeof *palette.values;
+
+	std::uint16_t base = std::max_element(counts, counts + palette.size) - counts;
+	std::size_t exceptionCount = BLOCKS_PER_SECTION - counts[base];
+	std::size_t exceptionsSize = 0;
+	std::size_t position = 0;
+	std::size_t lastException = 0;
+
+	for(std::size_t i = 0; i != runCount; ++i)
+	{
+		if(runs[i].index != base)
+		{
+			// the first block of the run is some distance from the previous exception, every other one follows it
+			exceptionsSize += varintSize(position - lastException) + runs[i].length - 1;
+			lastException = position + runs[i].length - 1;
+		}
+
+		position += runs[i].length;
+	}
+
+	auto packedTotal = paletteSize + packedSize(ceillog2(palette.size), BLOCKS_PER_SECTION);
+	auto runsTotal = paletteSize + sizeof(std::uint16_t) + runCount * indexSize + runsSize;
+	auto sparseTotal = paletteSize + indexSize + sizeof(std::uint16_t) + exceptionCount * indexSize + exceptionsSize;
+
+	if(packedTotal <= runsTotal && packedTotal <= sparseTotal)
+	{
+		out[0] = SECTION_PACKED;
+		auto size = writePalette(palette, out + 1);
+		return 1 + size + palettizeAndPackOptimized(palette, data, BLOCKS_PER_SECTION, out + 1 + size);
+	}
+
+	auto p = out + 1;
+	p += writePalette(palette, p);
+
+	if(runsTotal <= sparseTotal)
+	{
+		out[0] = SECTION_RUNS;
+		std::uint16_t count = runCount;
+		std::memcpy(p, &count, sizeof count);
+		p += sizeof count;
+
+		for(std::size_t i = 0; i != runCount; ++i)
+		{
+			p += writeIndex(runs[i].index, indexSize, p);
+			p += writeVarint(runs[i].length - 1, p);
+		}
+
+		return p - out;
+	}
+
+	out[0] = SECTION_SPARSE;
+	p += writeIndex(base, indexSize, p);
+	std::uint16_t count = exceptionCount;
+	std::memcpy(p, &count, sizeof count);
+	p += sizeof count;
+
+	position = 0;
+	lastException = 0;
+
+	for(std::size_t i = 0; i != runCount; ++i)
+	{
+		if(runs[i].index != base)
+		{
+			for(std::size_t j = 0; j != runs[i].length; ++j)
+			{
+				p += writeVarint(position + j - lastException, p);
+				p += writeIndex(runs[i].index, indexSize, p);
+				lastException = position + j;
+			}
+		}
+
+		position += runs[i].length;
+	}
+
+	return p - out;
+}
+
+// inverse of encodeSectionRle, returns the number of bytes consumed
+inline
+std::size_t decodeSectionRle(std::uint8_t const* in, std::uint16_t* out, BlockOrder blockOrder = BlockOrder::linear)
+{
+	if(blockOrder != BlockOrder::linear)
+	{
+		std::uint16_t buf[BLOCKS_PER_SECTION];
+		auto size = decodeSectionRle(in, buf);
+		restoreBlocks(buf, blockOrder, out);
+		return size;
+	}
+
+	if(in[0] == SECTION_PACKED)
+		return 1 + decodeSection(in + 1, out);
+
+	Palette palette;
+	auto p = in + 1;
+	p += readPalette(p, &palette);
+
+	auto indexSize = palette.size <= 256 ? 1 : 2;
+	std::uint16_t index;
+	std::uint32_t value;
+
+	if(in[0] == SECTION_RUNS)
+	{
+		std::uint16_t count;
+		std::memcpy(&count, p, sizeof count);
+		p += sizeof count;
+
+		for(std::size_t i = 0; i != count; ++i)
+		{
+			p += readIndex(p, indexSize, index);
+			p += readVarint(p, value);
+			out = std::fill_n(out, value + 1, palette.values[index]);
+		}
+
+		return p - in;
+	}
+
+	p += readIndex(p, indexSize, index);
+	std::fill_n(out, BLOCKS_PER_SECTION, palette.values[index]);
+
+	std::uint16_t count;
+	std::memcpy(&count, p, sizeof count);
+	p += sizeof count;
+
+	std::size_t position = 0;
+
+	for(std::size_t i = 0; i != count; ++i)
+	{
+		p += readVarint(p, value);
+		p += readIndex(p, indexSize, index);
+		position += value;
+		out[position] = palette.values[index];
+	}
+
+	return p - in;
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "bitpacking.hpp"
+#include "palette.hpp"
+#include "parser.hpp"
+
+inline
+std::size_t countNonAirBlocks(std::uint16_t const* section)
+{
+	std::size_t result = 0;
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+		if(section[i])
+			++result;
+
+	return result;
+}
+
+// the bins stats() reports sections in, applied to whole chunks: the highest palette bit depth of the sections and
+// the bit depth of the number of non-air blocks
+inline
+std::pair<int, int> chunkStratum(Chunk const& chunk)
+{
+	int paletteBits = 0;
+	std::size_t nonAirBlocks = 0;
+
+	for(auto section : chunk.sections())
+	{
+		paletteBits = std::max(paletteBits, ceillog2(createPalette(section, BLOCKS_PER_SECTION, true).size));
+		nonAirBlocks += countNonAirBlocks(section);
+	}
+
+	return {paletteBits, ceillog2(nonAirBlocks)};
+}
+
+// chunks drawn from every stratum in proportion to its size, each stratum gathered into a region of its own
+struct StratifiedSample
+{
+	std::vector<Region> strata;
+	// number of chunks of the world in every stratum
+	std::vector<std::size_t> populations;
+	// size of the raw sections of the whole world
+	std::size_t inputSize = 0;
+};
+
+// samples about fraction of the chunks, but at least two of every stratum so its spread can be estimated
+// the same seed always selects the same chunks of the same world
+inline
+StratifiedSample stratifiedSample(std::vector<Region> const& regions, double fraction, std::uint32_t seed = 0)
+{
+	std::map<std::pair<int, int>, std::vector<Chunk const*>> strata;
+	StratifiedSample sample;
+
+	for(auto& region : regions)
+	{
+		for(auto& chunk : region.chunks)
+		{
+			strata[chunkStratum(chunk)].push_back(&chunk);
+			sample.inputSize += chunk.sectionCount * BLOCKS_PER_SECTION * sizeof(std::uint16_t);
+		}
+	}
+
+	std::mt19937 random(seed);
+
+	for(auto& [key, chunks] : strata)
+	{
+		auto count = std::min(chunks.size(), std::max<std::size_t>(2, (std::size_t)std::ceil(fraction * chunks.size())));
+
+		std::vector<std::size_t> indices(chunks.size());
+		std::iota(indices.begin(), indices.end(), 0);
+
+		// partial fisher-yates, the first count indices end up as a uniform sample without replacement
+		for(std::size_t i = 0; i != count; ++i)
+			std::swap(indices[i], indices[std::uniform_int_distribution<std::size_t>(i, indices.size() - 1)(random)]);
+
+		// keep the world order within the stratum, so schemes see chunks in the order they would otherwise
+		std::sort(indices.begin(), indices.begin() + count);
+
+		Region region;
+
+		for(std::size_t i = 0; i != count; ++i)
+		{
+			auto& chunk = *chunks[indices[i]];
+			region.addChunk(chunk.index, chunk.sectionMask, chunk.firstSection);
+		}
+
+		sample.strata.push_back(std::move(region));
+		sample.populations.push_back(chunks.size());
+	}
+
+	return sample;
+}
+
+// sum of a quantity over every chunk of the world, estimated from the per-chunk values of a stratified sample,
+// along with the half width of its 95% confidence interval
+struct StratifiedEstimate
+{
+	double total = 0;
+	double error = 0;
+};
+
+inline
+StratifiedEstimate estimateTotal(std::vector<std::vector<double>> const& values, std::vector<std::size_t> const& populations)
+{
+	StratifiedEstimate estimate;
+	double variance = 0;
+
+	for(std::size_t h = 0; h != values.size(); ++h)
+	{
+		auto n = values[h].size();
+		auto population = (double)populations[h];
+
+		if(n == 0)
+			continue;
+
+		double sum = 0;
+
+		for(auto value : values[h])
+			sum += value;
+
+		auto mean = sum / n;
+		estimate.total += population * mean;
+
+		if(n < 2)
+			continue;
+
+		double squares = 0;
+
+		for(auto value : values[h])
+			squares += (value - mean) * (value - mean);
+
+		// with the finite population correction, a fully sampled stratum contributes no uncertainty
+		variance += population * population * (1 - n / population) * squares / (n - 1) / n;
+	}
+
+	// the strata together usually have enough samples for the normal approximation
+	estimate.error = 1.96 * std::sqrt(variance);
+	return estimate;
+}
+
+// runs the scheme over every stratum of the sample, timing every chunk on its own, and extrapolates the size and
+// time of the whole world
+// what endRegion() adds is spread over the chunks of the stratum, schemes compressing chunks together see the
+// sampled chunks as neighbours, which slightly favours them
+template <typename Scheme>
+BenchmarkResult benchmarkSampled(StratifiedSample const& sample, Scheme scheme)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<std::vector<double>> sizes(sample.strata.size());
+	std::vector<std::vector<double>> times(sample.strata.size());
+	auto startCpuTime = threadCpuTime();
+
+	for(std::size_t h = 0; h != sample.strata.size(); ++h)
+	{
+		auto& region = sample.strata[h];
+		scheme.beginRegion(region);
+
+		for(auto& chunk : region.chunks)
+		{
+			auto startTime = Clock::now();
+			std::size_t size = 0;
+
+			scheme.beginChunk(chunk);
+
+			for(auto section : chunk.sections())
+				size += scheme.section(section);
+
+			size += scheme.endChunk();
+
+			times[h].push_back(std::chrono::duration<double>(Clock::now() - startTime).count());
+			sizes[h].push_back(size);
+		}
+
+		auto startTime = Clock::now();
+		auto size = scheme.endRegion();
+		auto time = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+		for(std::size_t i = 0; i != sizes[h].size(); ++i)
+		{
+			sizes[h][i] += (double)size / sizes[h].size();
+			times[h][i] += time / times[h].size();
+		}
+	}
+
+	auto endCpuTime = threadCpuTime();
+
+	std::size_t sampleChunks = 0;
+	std::size_t chunks = 0;
+
+	for(std::size_t h = 0; h != sample.strata.size(); ++h)
+	{
+		sampleChunks += sample.strata[h].chunks.size();
+		chunks += sample.populations[h];
+	}
+
+	auto size = estimateTotal(sizes, sample.populations);
+	auto time = estimateTotal(times, sample.populations);
+
+	BenchmarkResult result;
+	result.scheme = scheme.name();
+	result.inputSize = sample.inputSize;
+	result.size = (std::size_t)size.total;
+	result.sizeError = size.error;
+	result.time = time.total;
+	result.timeError = time.error;
+	result.cpuTime = sampleChunks == 0 ? 0 : (endCpuTime - startCpuTime) * chunks / sampleChunks;
+	return result;
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "../compressors/lz4.hpp"
+#include "../compressors/null.hpp"
+#include "../compressors/zstd.hpp"
+#include "../palette.hpp"
+#include "../palettepack.hpp"
+#include "../parser.hpp"
+
+enum class AdaptivePolicy
+{
+	// picks the compressor from the palette bit depths and the size of the encoded chunk
+	heuristic,
+	// compresses with the cheap compressors and keeps the smallest output, only trying zstd-high on large chunks
+	trial,
+};
+
+// the opt2 encoding, with the compressor picked per chunk between null, lz4, a low and a high zstd level
+// every compressed chunk starts with a byte naming the method it was compressed with
+class AdaptiveCompressionScheme
+{
+public:
+	enum Method : std::uint8_t
+	{
+		METHOD_NULL,
+		METHOD_LZ4,
+		METHOD_ZSTD_LOW,
+		METHOD_ZSTD_HIGH,
+	};
+
+private:
+	// payloads this small are mostly palettes of uniform sections, compressing them saves a few bytes at most
+	static constexpr std::size_t SMALL_PAYLOAD_SIZE = 256;
+	// below this size, zstd-low usually doesn't find enough beyond lz4 to pay for its slower decoding
+	static constexpr std::size_t LZ4_PAYLOAD_SIZE = 4096;
+	// only chunks whose smallest output of the faster methods is at least this big are tried with zstd-high
+	static constexpr std::size_t HIGH_TRIAL_SIZE = 1024;
+	// in trial mode, a slower method has to save this fraction of the faster method's output to be picked
+	static constexpr float TRIAL_MIN_GAIN = 0.05f;
+
+	AdaptivePolicy _policy;
+	int _lowLevel;
+	int _highLevel;
+	NullCompressor _null;
+	Lz4Compressor _lz4;
+	ZstdCompressor _zstdLow;
+	ZstdCompressor _zstdHigh;
+	NullDecompressor _nullDecompressor;
+	Lz4Decompressor _lz4Decompressor;
+	ZstdDecompressor _zstdDecompressor;
+	std::vector<std::uint8_t> _chunkBuffer;
+	std::size_t _bufferUsed = 0;
+	// highest palette bit depth of the sections of the current chunk
+	int _maxBits = 0;
+	// the tag byte followed by the compressed payload
+	std::vector<std::uint8_t> _compressedBuffer;
+	std::vector<std::uint8_t> _trialBuffer;
+	PaletteOrder _paletteOrder;
+	BlockOrder _blockOrder;
+
+	std::size_t compress(Method method, std::uint8_t* out, std::size_t outSize)
+	{
+		switch(method)
+		{
+		case METHOD_NULL: return _null.compress(_chunkBuffer.data(), _bufferUsed, out, outSize);
+		case METHOD_LZ4: return _lz4.compress(_chunkBuffer.data(), _bufferUsed, out, outSize);
+		case METHOD_ZSTD_LOW: return _zstdLow.compress(_chunkBuffer.data(), _bufferUsed, out, outSize);
+		case METHOD_ZSTD_HIGH: return _zstdHigh.compress(_chunkBuffer.data(), _bufferUsed, out, outSize);
+		default: break;
+		}
+
+		std::fprintf(stderr, "adaptive: invalid method %d\n", (int)method);
+		std::terminate();
+	}
+
+	Method selectHeuristic() const
+	{
+		if(_maxBits == 0 || _bufferUsed <= SMALL_PAYLOAD_SIZE)
+			return METHOD_NULL;
+
+		if(_bufferUsed <= LZ4_PAYLOAD_SIZE || _maxBits <= 1)
+			return METHOD_LZ4;
+
+		// dense terrain with many distinct blocks is where the higher level finds the most
+		if(_maxBits >= 5)
+			return METHOD_ZSTD_HIGH;
+
+		return METHOD_ZSTD_LOW;
+	}
+
+	// compresses the chunk with increasingly slow methods, each of which has to beat the best one so far by
+	// TRIAL_MIN_GAIN, and leaves the winner in the compressed buffer
+	std::size_t compressTrial()
+	{
+		auto out = _compressedBuffer.data() + 1;
+		auto outSize = _compressedBuffer.size() - 1;
+
+		auto best = METHOD_NULL;
+		auto bestSize = _bufferUsed;
+
+		if(_bufferUsed > SMALL_PAYLOAD_SIZE)
+		{
+			for(auto method : {METHOD_LZ4, METHOD_ZSTD_LOW, METHOD_ZSTD_HIGH})
+			{
+				if(method == METHOD_ZSTD_HIGH && bestSize < HIGH_TRIAL_SIZE)
+					break;
+
+				auto size = compress(method, _trialBuffer.data(), _trialBuffer.size());
+
+				if(size < bestSize * (1 - TRIAL_MIN_GAIN))
+				{
+					std::memcpy(out, _trialBuffer.data(), size);
+					best = method;
+					bestSize = size;
+				}
+			}
+		}
+
+		if(best == METHOD_NULL)
+			compress(METHOD_NULL, out, outSize);
+
+		_compressedBuffer[0] = best;
+		return bestSize;
+	}
+
+public:
+	explicit AdaptiveCompressionScheme(AdaptivePolicy policy, int lowLevel = 1, int highLevel = 19, PaletteOrder paletteOrder = PaletteOrder::firstSeen,
+	                                   BlockOrder blockOrder = BlockOrder::linear)
+	: _policy(policy)
+	, _lowLevel(lowLevel)
+	, _highLevel(highLevel)
+	, _lz4(0)
+	, _zstdLow(lowLevel)
+	, _zstdHigh(highLevel)
+	, _chunkBuffer(MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(1 + 8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _trialBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
+	, _blockOrder(blockOrder)
+	{}
+
+	std::string name() const
+	{
+		return "adaptive" + paletteOrderSuffix(_paletteOrder) + blockOrderSuffix(_blockOrder) + ":" + (_policy == AdaptivePolicy::heuristic ? "heuristic" : "trial")
+		       + "/" + std::to_string(_lowLevel) + "-" + std::to_string(_highLevel);
+	}
+
+	void beginRegion(Region const& region)
+	{
+	}
+
+	std::size_t endRegion()
+	{
+		return 0;
+	}
+
+	void beginChunk(Chunk const& chunk)
+	{
+		_maxBits = 0;
+	}
+
+	std::size_t endChunk()
+	{
+		std::size_t size;
+
+		if(_policy == AdaptivePolicy::trial)
+			size = compressTrial();
+		else
+		{
+			auto method = selectHeuristic();
+			_compressedBuffer[0] = method;
+			size = compress(method, _compressedBuffer.data() + 1, _compressedBuffer.size() - 1);
+		}
+
+		_bufferUsed = 0;
+		return 1 + size;
+	}
+
+	std::size_t section(std::uint16_t const* data)
+	{
+		auto size = encodeSection(data, _chunkBuffer.data() + _bufferUsed, _paletteOrder, _blockOrder);
+
+		// the encoded section starts with its palette size
+		std::uint16_t paletteSize;
+		std::memcpy(&paletteSize, _chunkBuffer.data() + _bufferUsed, sizeof paletteSize);
+		_maxBits = std::max<int>(_maxBits, ceillog2(paletteSize));
+
+		_bufferUsed += size;
+		return 0;
+	}
+
+	// compressed data of the chunk most recently finished by endChunk(), including the method tag
+	std::uint8_t const* compressedChunk() const
+	{
+		return _compressedBuffer.data();
+	}
+
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		auto data = in + 1;
+		auto size = inSize - 1;
+		auto buffer = _chunkBuffer.data();
+		auto bufferSize = _chunkBuffer.size();
+
+		switch(in[0])
+		{
+		case METHOD_NULL: _nullDecompressor.decompress(data, size, buffer, bufferSize); break;
+		case METHOD_LZ4: _lz4Decompressor.decompress(data, size, buffer, bufferSize); break;
+		case METHOD_ZSTD_LOW: case METHOD_ZSTD_HIGH: _zstdDecompressor.decompress(data, size, buffer, bufferSize); break;
+
+		default:
+			std::fprintf(stderr, "adaptive: invalid method %d\n", (int)in[0]);
+			std::terminate();
+		}
+
+		auto p = buffer;
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+			p += decodeSection(p, out + i * BLOCKS_PER_SECTION, _blockOrder);
+	}
+};
@@ -7,26 +7,36 @@
 #include <utility>
 #include <vector>
 
-#include <zstd.h>
-
 #include "../bitpacking.hpp"
+#include "../palette.hpp"
+#include "../palettepack.hpp"
+#include "../parser.hpp"
 
 template <typename Compressor>
 struct Opt2CompressionScheme
 {
 	Compressor _compressor;
+	decltype(_compressor.decompressor()) _decompressor;
 	std::vector<std::uint8_t> _chunkBuffer;
+	// use a buffer bigger than necessary for better performance with some compression algorithms
+	std::vector<std::uint8_t> _compressedBuffer;
 	std::size_t _bufferUsed = 0;
+	PaletteOrder _paletteOrder;
+	BlockOrder _blockOrder;
 
 	template <typename... P>
-	explicit Opt2CompressionScheme(P&&... p)
+	explicit Opt2CompressionScheme(PaletteOrder paletteOrder, BlockOrder blockOrder, P&&... p)
 	: _compressor(std::forward<P>(p)...)
-	, _chunkBuffer(BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _decompressor(_compressor.decompressor())
+	, _chunkBuffer(MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
+	, _blockOrder(blockOrder)
 	{}
 
 	std::string name() const
 	{
-		return "opt2:" + _compressor.name();
+		return "opt2" + paletteOrderSuffix(_paletteOrder) + blockOrderSuffix(_blockOrder) + ":" + _compressor.name();
 	}
 
 	void beginRegion(Region const& region)
@@ -44,23 +54,37 @@ struct Opt2CompressionScheme
 
 	std::size_t endChunk()
 	{
-		// use a buffer bigger than necessary for better performance with some compression algorithms
-		std::uint8_t compressedBuffer[8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK];
-		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, compressedBuffer, sizeof compressedBuffer);
+		auto size = compressPayload(_chunkBuffer.data(), _bufferUsed);
 		_bufferUsed = 0;
 		return size;
 	}
 
-	std::size_t section(std::uint16_t const* data)
+	// compresses the encoded sections of a whole chunk, which is all endChunk() does besides resetting the buffer
+	// exposed separately so payloads can be encoded once and then fed to every compressor
+	std::size_t compressPayload(std::uint8_t const* payload, std::size_t size)
 	{
-		auto palette = createPalette(data, BLOCKS_PER_SECTION, false);
-
-		std::uint16_t buf[BLOCKS_PER_SECTION];
-		palettize(palette, data, BLOCKS_PER_SECTION, buf, false);
+		return _compressor.compress(payload, size, _compressedBuffer.data(), _compressedBuffer.size());
+	}
 
-		auto size = bitpackOptimized(palette.size, buf, BLOCKS_PER_SECTION, _chunkBuffer.data() + _bufferUsed);
-		_bufferUsed += size;
+	// compressed data of the chunk most recently finished by endChunk()
+	std::uint8_t const* compressedChunk() const
+	{
+		return _compressedBuffer.data();
+	}
 
+	std::size_t section(std::uint16_t const* data)
+	{
+		_bufferUsed += encodeSection(data, _chunkBuffer.data() + _bufferUsed, _paletteOrder, _blockOrder);
 		return 0;
 	}
+
+	// inverse of the section()/endChunk() sequence, writes sectionCount sections to out
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		_decompressor.decompress(in, inSize, _chunkBuffer.data(), _chunkBuffer.size());
+		auto p = _chunkBuffer.data();
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+			p += decodeSection(p, out + i * BLOCKS_PER_SECTION, _blockOrder);
+	}
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../parser.hpp"
+#include "../predictpack.hpp"
+
+// the opt2 scheme with every section coded against the section directly below it in the same chunk, storing only
+// the blocks that differ from it when that is smaller
+// chunks stay independent of each other, so single chunks can still be decoded on their own
+template <typename Compressor>
+struct PredictiveCompressionScheme
+{
+	Compressor _compressor;
+	decltype(_compressor.decompressor()) _decompressor;
+	std::vector<std::uint8_t> _chunkBuffer;
+	// use a buffer bigger than necessary for better performance with some compression algorithms
+	std::vector<std::uint8_t> _compressedBuffer;
+	std::size_t _bufferUsed = 0;
+	// sections of the current chunk that are yet to come, and the previous one if it is directly below the next
+	std::uint16_t _remainingMask = 0;
+	std::uint16_t const* _predictor = nullptr;
+	PaletteOrder _paletteOrder;
+
+	template <typename... P>
+	explicit PredictiveCompressionScheme(PaletteOrder paletteOrder, P&&... p)
+	: _compressor(std::forward<P>(p)...)
+	, _decompressor(_compressor.decompressor())
+	, _chunkBuffer(MAX_PREDICTED_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
+	{}
+
+	std::string name() const
+	{
+		return "predictive" + paletteOrderSuffix(_paletteOrder) + ":" + _compressor.name();
+	}
+
+	void beginRegion(Region const& region)
+	{
+	}
+
+	std::size_t endRegion()
+	{
+		return 0;
+	}
+
+	void beginChunk(Chunk const& chunk)
+	{
+		_remainingMask = chunk.sectionMask;
+		_predictor = nullptr;
+	}
+
+	std::size_t endChunk()
+	{
+		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, _compressedBuffer.data(), _compressedBuffer.size());
+		_bufferUsed = 0;
+		return size;
+	}
+
+	// compressed data of the chunk most recently finished by endChunk()
+	std::uint8_t const* compressedChunk() const
+	{
+		return _compressedBuffer.data();
+	}
+
+	std::size_t section(std::uint16_t const* data)
+	{
+		_bufferUsed += encodeSectionPredicted(data, _predictor, _chunkBuffer.data() + _bufferUsed, _paletteOrder);
+
+		// the lowest remaining bit is this section, it predicts the next one only if that is the next bit up
+		auto y = __builtin_ctz(_remainingMask);
+		_remainingMask &= _remainingMask - 1;
+		_predictor = _remainingMask & (2u << y) ? data : nullptr;
+		return 0;
+	}
+
+	// inverse of the section()/endChunk() sequence, writes sectionCount sections to out
+	// the encoding records which sections were predicted, so the section mask isn't needed
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		_decompressor.decompress(in, inSize, _chunkBuffer.data(), _chunkBuffer.size());
+		auto p = _chunkBuffer.data();
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+		{
+			auto predictor = i == 0 ? nullptr : out + (i - 1) * BLOCKS_PER_SECTION;
+			p += decodeSectionPredicted(p, predictor, out + i * BLOCKS_PER_SECTION);
+		}
+	}
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../palettepack.hpp"
+#include "../parser.hpp"
+
+// the opt2 encoding, but compressing groups of chunksPerFrame consecutive chunks as a single frame
+// an index of the frame offsets and the position of every chunk within its decompressed frame keeps single chunks
+// addressable, at the cost of decompressing their whole frame
+template <typename Compressor>
+struct RegionCompressionScheme
+{
+	struct ChunkEntry
+	{
+		std::uint32_t frame;
+		// position within the decompressed frame
+		std::uint32_t offset;
+		std::uint32_t sectionCount;
+	};
+
+	struct FrameEntry
+	{
+		std::uint32_t offset;
+		std::uint32_t size;
+		std::uint32_t decompressedSize;
+	};
+
+	Compressor _compressor;
+	decltype(_compressor.decompressor()) _decompressor;
+	std::size_t _chunksPerFrame;
+	std::vector<std::uint8_t> _frameBuffer;
+	std::size_t _frameUsed = 0;
+	std::size_t _frameChunks = 0;
+	std::vector<std::uint8_t> _compressedBuffer;
+	// the compressed frames of the current region and their index
+	std::vector<std::uint8_t> _regionData;
+	std::vector<FrameEntry> _frames;
+	std::vector<ChunkEntry> _chunks;
+	PaletteOrder _paletteOrder;
+	BlockOrder _blockOrder;
+
+	template <typename... P>
+	explicit RegionCompressionScheme(std::size_t chunksPerFrame, PaletteOrder paletteOrder, BlockOrder blockOrder, P&&... p)
+	: _compressor(std::forward<P>(p)...)
+	, _decompressor(_compressor.decompressor())
+	, _chunksPerFrame(chunksPerFrame)
+	, _paletteOrder(paletteOrder)
+	, _blockOrder(blockOrder)
+	{}
+
+	std::string name() const
+	{
+		return "region" + std::to_string(_chunksPerFrame) + paletteOrderSuffix(_paletteOrder) + blockOrderSuffix(_blockOrder) + ":" + _compressor.name();
+	}
+
+	void beginRegion(Region const& region)
+	{
+		_regionData.clear();
+		_frames.clear();
+		_chunks.clear();
+	}
+
+	std::size_t endRegion()
+	{
+		auto size = flushFrame();
+
+		// the index stores the frame table and one chunk offset, frames and section counts follow from the chunk order
+		return size + _frames.size() * sizeof(FrameEntry) + _chunks.size() * sizeof(std::uint32_t);
+	}
+
+	void beginChunk(Chunk const& chunk)
+	{
+		_chunks.push_back({(std::uint32_t)_frames.size(), (std::uint32_t)_frameUsed, 0});
+		_frameBuffer.resize(_frameUsed + MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK);
+	}
+
+	std::size_t endChunk()
+	{
+		if(++_frameChunks != _chunksPerFrame)
+			return 0;
+
+		return flushFrame();
+	}
+
+	std::size_t section(std::uint16_t const* data)
+	{
+		_frameUsed += encodeSection(data, _frameBuffer.data() + _frameUsed, _paletteOrder, _blockOrder);
+		++_chunks.back().sectionCount;
+		return 0;
+	}
+
+	// decodes the index-th chunk of the current region, counting only present chunks
+	void readChunk(std::size_t index, std::uint16_t* out)
+	{
+		auto& chunk = _chunks[index];
+		auto& frame = _frames[chunk.frame];
+
+		_frameBuffer.resize(frame.decompressedSize);
+		_decompressor.decompress(_regionData.data() + frame.offset, frame.size, _frameBuffer.data(), _frameBuffer.size());
+
+		auto p = _frameBuffer.data() + chunk.offset;
+
+		for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+			p += decodeSection(p, out + i * BLOCKS_PER_SECTION, _blockOrder);
+	}
+
+	std::size_t chunkCount() const
+	{
+		return _chunks.size();
+	}
+
+private:
+	std::size_t flushFrame()
+	{
+		if(_frameChunks == 0)
+			return 0;
+
+		// twice the input is more than any of the compressors need for incompressible data
+		_compressedBuffer.resize(2 * _frameUsed + 1024);
+		auto size = _compressor.compress(_frameBuffer.data(), _frameUsed, _compressedBuffer.data(), _compressedBuffer.size());
+
+		_frames.push_back({(std::uint32_t)_regionData.size(), (std::uint32_t)size, (std::uint32_t)_frameUsed});
+		_regionData.insert(_regionData.end(), _compressedBuffer.data(), _compressedBuffer.data() + size);
+
+		_frameUsed = 0;
+		_frameChunks = 0;
+		return size;
+	}
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../parser.hpp"
+#include "../rlepack.hpp"
+
+// the opt2 scheme with every section stored as runs, as its most common block plus exceptions or packed, whichever
+// is smallest
+template <typename Compressor>
+struct RleCompressionScheme
+{
+	Compressor _compressor;
+	decltype(_compressor.decompressor()) _decompressor;
+	std::vector<std::uint8_t> _chunkBuffer;
+	// use a buffer bigger than necessary for better performance with some compression algorithms
+	std::vector<std::uint8_t> _compressedBuffer;
+	std::size_t _bufferUsed = 0;
+	PaletteOrder _paletteOrder;
+	BlockOrder _blockOrder;
+
+	template <typename... P>
+	explicit RleCompressionScheme(PaletteOrder paletteOrder, BlockOrder blockOrder, P&&... p)
+	: _compressor(std::forward<P>(p)...)
+	, _decompressor(_compressor.decompressor())
+	, _chunkBuffer(MAX_RLE_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
+	, _blockOrder(blockOrder)
+	{}
+
+	std::string name() const
+	{
+		return "rle" + paletteOrderSuffix(_paletteOrder) + blockOrderSuffix(_blockOrder) + ":" + _compressor.name();
+	}
+
+	void beginRegion(Region const& region)
+	{
+	}
+
+	std::size_t endRegion()
+	{
+		return 0;
+	}
+
+	void beginChunk(Chunk const& chunk)
+	{
+	}
+
+	std::size_t endChunk()
+	{
+		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, _compressedBuffer.data(), _compressedBuffer.size());
+		_bufferUsed = 0;
+		return size;
+	}
+
+	// compressed data of the chunk most recently finished by endChunk()
+	std::uint8_t const* compressedChunk() const
+	{
+		return _compressedBuffer.data();
+	}
+
+	std::size_t section(std::uint16_t const* data)
+	{
+		_bufferUsed += encodeSectionRle(data, _chunkBuffer.data() + _bufferUsed, _paletteOrder, _blockOrder);
+		return 0;
+	}
+
+	// inverse of the section()/endChunk() sequence, writes sectionCount sections to out
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		_decompressor.decompress(in, inSize, _chunkBuffer.data(), _chunkBuffer.size());
+		auto p = _chunkBuffer.data();
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+			p += decodeSectionRle(p, out + i * BLOCKS_PER_SECTION, _blockOrder);
+	}
+};
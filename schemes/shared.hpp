@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../bitpacking.hpp"
+#include "../palette.hpp"
+#include "../palettepack.hpp"
+#include "../parser.hpp"
+
+// the opt2 encoding with one palette for the whole chunk, written once in front of its sections
+// every section is packed against the chunk palette with its bit width, unless its own palette and width are smaller,
+// in which case it is stored in the opt2 format
+// chunk layout: the chunk palette, a 16-bit mask of the sections with their own palette, then the sections
+template <typename Compressor>
+struct SharedPaletteCompressionScheme
+{
+	Compressor _compressor;
+	decltype(_compressor.decompressor()) _decompressor;
+	std::vector<std::uint8_t> _chunkBuffer;
+	std::vector<std::uint8_t> _compressedBuffer;
+	std::size_t _bufferUsed = 0;
+	Palette _chunkPalette;
+	std::vector<Palette> _sectionPalettes;
+	std::uint16_t _ownPaletteMask = 0;
+	std::size_t _section = 0;
+	PaletteOrder _paletteOrder;
+	BlockOrder _blockOrder;
+
+	template <typename... P>
+	explicit SharedPaletteCompressionScheme(PaletteOrder paletteOrder, BlockOrder blockOrder, P&&... p)
+	: _compressor(std::forward<P>(p)...)
+	, _decompressor(_compressor.decompressor())
+	, _chunkBuffer(sizeof(std::uint16_t) * (2 + MAX_PALETTE_SIZE) + MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _sectionPalettes(SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
+	, _blockOrder(blockOrder)
+	{}
+
+	std::string name() const
+	{
+		return "shared" + paletteOrderSuffix(_paletteOrder) + blockOrderSuffix(_blockOrder) + ":" + _compressor.name();
+	}
+
+	void beginRegion(Region const& region)
+	{
+	}
+
+	std::size_t endRegion()
+	{
+		return 0;
+	}
+
+	// builds the palettes of all sections and merges them into the chunk palette, then decides which sections use it
+	void beginChunk(Chunk const& chunk)
+	{
+		static thread_local std::uint64_t seen[(1 << 16) / 64];
+
+		_chunkPalette.size = 0;
+		bool fits = true;
+
+		for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+		{
+			auto& palette = _sectionPalettes[i];
+			palette = createPalette(chunk.firstSection[i], BLOCKS_PER_SECTION, false);
+
+			for(std::size_t j = 0; j != palette.size && fits; ++j)
+			{
+				auto value = palette.values[j];
+				auto& word = seen[value / 64];
+				auto bit = 1ull << (value % 64);
+
+				if(word & bit)
+					continue;
+
+				// chunks can have more distinct blocks than a palette holds, their sections keep their own palettes
+				if(_chunkPalette.size == MAX_PALETTE_SIZE)
+				{
+					fits = false;
+					break;
+				}
+
+				word |= bit;
+				_chunkPalette.values[_chunkPalette.size++] = value;
+			}
+		}
+
+		for(std::size_t i = 0; i != _chunkPalette.size; ++i)
+			seen[_chunkPalette.values[i] / 64] = 0;
+
+		// chunks without sections have an empty chunk palette
+		auto sharedSize = _chunkPalette.size == 0 ? 0 : packedSize(ceillog2(_chunkPalette.size), BLOCKS_PER_SECTION);
+		_ownPaletteMask = 0;
+
+		for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+		{
+			auto& palette = _sectionPalettes[i];
+			auto ownSize = sizeof palette.size + palette.size * sizeof *palette.values + packedSize(ceillog2(palette.size), BLOCKS_PER_SECTION);
+
+			if(!fits || ownSize < sharedSize)
+				_ownPaletteMask |= 1 << i;
+		}
+
+		// without any section using it, the chunk palette isn't worth storing
+		if(_ownPaletteMask == (1 << chunk.sectionCount) - 1)
+			_chunkPalette.size = 0;
+
+		if(_paletteOrder == PaletteOrder::frequency)
+			sortPalettes(chunk);
+
+		_bufferUsed = writePalette(_chunkPalette, _chunkBuffer.data());
+		std::memcpy(_chunkBuffer.data() + _bufferUsed, &_ownPaletteMask, sizeof _ownPaletteMask);
+		_bufferUsed += sizeof _ownPaletteMask;
+		_section = 0;
+	}
+
+	// orders the chunk palette by the occurrences in the sections sharing it, the other palettes by their own section
+	void sortPalettes(Chunk const& chunk)
+	{
+		std::uint32_t counts[MAX_PALETTE_SIZE] = {};
+
+		for(std::size_t i = 0; i != chunk.sectionCount; ++i)
+		{
+			if(_ownPaletteMask & (1 << i))
+				sortPaletteByFrequency(_sectionPalettes[i], chunk.firstSection[i], BLOCKS_PER_SECTION);
+			else
+				countPaletteEntries(_chunkPalette, chunk.firstSection[i], BLOCKS_PER_SECTION, counts);
+		}
+
+		sortPaletteByCounts(_chunkPalette, counts);
+	}
+
+	std::size_t endChunk()
+	{
+		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, _compressedBuffer.data(), _compressedBuffer.size());
+		_bufferUsed = 0;
+		return size;
+	}
+
+	// compressed data of the chunk most recently finished by endChunk()
+	std::uint8_t const* compressedChunk() const
+	{
+		return _compressedBuffer.data();
+	}
+
+	std::size_t section(std::uint16_t const* data)
+	{
+		auto out = _chunkBuffer.data() + _bufferUsed;
+		auto& palette = _ownPaletteMask & (1 << _section) ? _sectionPalettes[_section] : _chunkPalette;
+
+		if(_ownPaletteMask & (1 << _section))
+			out += writePalette(palette, out);
+
+		std::uint16_t buf[BLOCKS_PER_SECTION];
+		out += palettizeAndPackOptimized(palette, reorderBlocks(data, _blockOrder, buf), BLOCKS_PER_SECTION, out);
+		_bufferUsed = out - _chunkBuffer.data();
+		++_section;
+		return 0;
+	}
+
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		_decompressor.decompress(in, inSize, _chunkBuffer.data(), _chunkBuffer.size());
+
+		auto p = _chunkBuffer.data();
+		p += readPalette(p, &_chunkPalette);
+
+		std::uint16_t ownPaletteMask;
+		std::memcpy(&ownPaletteMask, p, sizeof ownPaletteMask);
+		p += sizeof ownPaletteMask;
+
+		std::uint16_t buf[BLOCKS_PER_SECTION];
+		std::uint16_t indices[BLOCKS_PER_SECTION];
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+		{
+			if(ownPaletteMask & (1 << i))
+				p += decodeSection(p, out + i * BLOCKS_PER_SECTION, _blockOrder);
+			else
+			{
+				p += bitunpackOptimized(_chunkPalette.size, p, BLOCKS_PER_SECTION, buf);
+				restoreBlocks(buf, _blockOrder, indices);
+				depalettize(_chunkPalette, indices, BLOCKS_PER_SECTION, out + i * BLOCKS_PER_SECTION);
+			}
+		}
+	}
+};
@@ -4,25 +4,33 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "../bitpacking.hpp"
 #include "../palette.hpp"
+#include "../palettepack.hpp"
+#include "../parser.hpp"
 #include "../compressors/zlib.hpp"
 
 struct VanillaCompressionScheme
 {
 	ZlibCompressor _compressor;
+	ZlibDecompressor _decompressor;
 	std::vector<std::uint8_t> _chunkBuffer;
+	std::vector<std::uint8_t> _compressedBuffer;
 	std::size_t _bufferUsed = 0;
+	PaletteOrder _paletteOrder;
 
-	VanillaCompressionScheme()
+	explicit VanillaCompressionScheme(PaletteOrder paletteOrder = PaletteOrder::firstSeen)
 	: _compressor(-1)
-	, _chunkBuffer(BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _chunkBuffer(MAX_ENCODED_SECTION_SIZE * SECTIONS_PER_CHUNK)
+	, _compressedBuffer(8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK)
+	, _paletteOrder(paletteOrder)
 	{}
 
 	std::string name() const
 	{
-		return "vanilla";
+		return "vanilla" + paletteOrderSuffix(_paletteOrder);
 	}
 
 	void beginRegion(Region const& region)
@@ -40,22 +48,43 @@ struct VanillaCompressionScheme
 
 	std::size_t endChunk()
 	{
-		std::uint8_t compressedBuffer[8 * BLOCKS_PER_SECTION * SECTIONS_PER_CHUNK];
-		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, compressedBuffer, sizeof compressedBuffer);
+		auto size = _compressor.compress(_chunkBuffer.data(), _bufferUsed, _compressedBuffer.data(), _compressedBuffer.size());
 		_bufferUsed = 0;
 		return size;
 	}
 
-	std::size_t section(std::uint16_t const* data)
+	// compressed data of the chunk most recently finished by endChunk()
+	std::uint8_t const* compressedChunk() const
 	{
-		auto palette = createPalette(data, BLOCKS_PER_SECTION, false);
+		return _compressedBuffer.data();
+	}
 
-		std::uint16_t buf[BLOCKS_PER_SECTION];
-		palettize(palette, data, BLOCKS_PER_SECTION, buf, false);
+	std::size_t section(std::uint16_t const* data)
+	{
+		auto palette = createPalette(data, BLOCKS_PER_SECTION, false, _paletteOrder);
+		_bufferUsed += writePalette(palette, _chunkBuffer.data() + _bufferUsed);
 
-		auto size = bitpackVanilla(palette.size, buf, BLOCKS_PER_SECTION, _chunkBuffer.data() + _bufferUsed);
+		auto size = palettizeAndPackVanilla(palette, data, BLOCKS_PER_SECTION, _chunkBuffer.data() + _bufferUsed);
 		_bufferUsed += size;
 
 		return 0;
 	}
+
+	// inverse of the section()/endChunk() sequence, writes sectionCount sections to out
+	void decodeChunk(std::uint8_t const* in, std::size_t inSize, std::size_t sectionCount, std::uint16_t* out)
+	{
+		_decompressor.decompress(in, inSize, _chunkBuffer.data(), _chunkBuffer.size());
+		auto p = _chunkBuffer.data();
+
+		for(std::size_t i = 0; i != sectionCount; ++i)
+		{
+			Palette palette;
+			p += readPalette(p, &palette);
+
+			std::uint16_t buf[BLOCKS_PER_SECTION];
+			p += bitunpackVanilla(palette.size, p, BLOCKS_PER_SECTION, buf);
+
+			depalettize(palette, buf, BLOCKS_PER_SECTION, out + i * BLOCKS_PER_SECTION);
+		}
+	}
 };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// summary of repeated measurements of the same quantity
+struct Statistics
+{
+	std::size_t count = 0;
+	double mean = 0;
+	double median = 0;
+	double stddev = 0;
+	double min = 0;
+	double max = 0;
+	// half width of the 95% confidence interval of the mean
+	double confidence = 0;
+};
+
+// two-sided 97.5% quantile of Student's t distribution, which turns the standard error into the half width of a 95%
+// confidence interval when the spread has to be estimated from few samples
+inline
+double studentT975(std::size_t degreesOfFreedom)
+{
+	static double const table[] =
+	{
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+	};
+
+	if(degreesOfFreedom == 0)
+		return 0;
+
+	if(degreesOfFreedom <= sizeof table / sizeof *table)
+		return table[degreesOfFreedom - 1];
+
+	// close enough to the normal distribution from here on
+	return 1.960;
+}
+
+inline
+Statistics summarize(std::vector<double> samples)
+{
+	Statistics statistics;
+	statistics.count = samples.size();
+
+	if(samples.empty())
+		return statistics;
+
+	std::sort(samples.begin(), samples.end());
+
+	auto n = samples.size();
+	double sum = 0;
+
+	for(auto sample : samples)
+		sum += sample;
+
+	statistics.mean = sum / n;
+	statistics.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+	statistics.min = samples.front();
+	statistics.max = samples.back();
+
+	if(n < 2)
+		return statistics;
+
+	double squares = 0;
+
+	for(auto sample : samples)
+		squares += (sample - statistics.mean) * (sample - statistics.mean);
+
+	statistics.stddev = std::sqrt(squares / (n - 1));
+	statistics.confidence = studentT975(n - 1) * statistics.stddev / std::sqrt((double)n);
+	return statistics;
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "chunkcache.hpp"
+#include "parser.hpp"
+#include "sampling.hpp"
+#include "threadpool.hpp"
+
+// a scheme type with its constructor arguments bound, so configurations can be stored in a list and run in any order
+struct Configuration
+{
+	std::string name;
+	std::function<BenchmarkResult(std::vector<Region> const&)> benchmark;
+	std::function<std::vector<BenchmarkResult>(std::vector<Region> const&, std::size_t)> benchmarkParallel;
+	std::function<BenchmarkResult(std::vector<Region> const&)> benchmarkDecode;
+	std::function<void(std::vector<Region> const&)> benchmarkLatency;
+	std::function<BenchmarkResult(StratifiedSample const&)> benchmarkSampled;
+	// only set for schemes that can compress cached chunk payloads
+	std::function<BenchmarkResult(ChunkCache const&)> benchmarkCached;
+};
+
+// schemes compressing several chunks together decode single chunks of the last region instead of whole chunks
+template <typename Scheme, typename = void>
+struct ReadsChunks : std::false_type {};
+
+template <typename Scheme>
+struct ReadsChunks<Scheme, std::void_t<decltype(std::declval<Scheme&>().readChunk(0, nullptr))>> : std::true_type {};
+
+template <typename Scheme, typename = void>
+struct CompressesPayloads : std::false_type {};
+
+template <typename Scheme>
+struct CompressesPayloads<Scheme, std::void_t<decltype(std::declval<Scheme&>().compressPayload(nullptr, 0))>> : std::true_type {};
+
+template <typename Scheme, typename... P>
+Configuration makeConfiguration(P... p)
+{
+	Configuration configuration;
+	configuration.name = Scheme(p...).name();
+	configuration.benchmark = [=](std::vector<Region> const& regions) { return ::benchmark(regions, Scheme(p...)); };
+	configuration.benchmarkParallel = [=](std::vector<Region> const& regions, std::size_t threads)
+	{
+		return ::benchmarkParallel(regions, threads, [&] { return Scheme(p...); });
+	};
+	configuration.benchmarkLatency = [=](std::vector<Region> const& regions) { ::benchmarkLatency(regions, Scheme(p...)); };
+	configuration.benchmarkSampled = [=](StratifiedSample const& sample) { return ::benchmarkSampled(sample, Scheme(p...)); };
+
+	if constexpr(ReadsChunks<Scheme>::value)
+		configuration.benchmarkDecode = [=](std::vector<Region> const& regions) { return benchmarkRandomAccess(regions, Scheme(p...)); };
+	else
+		configuration.benchmarkDecode = [=](std::vector<Region> const& regions) { return ::benchmarkDecode(regions, Scheme(p...)); };
+
+	if constexpr(CompressesPayloads<Scheme>::value)
+		configuration.benchmarkCached = [=](ChunkCache const& cache) { return ::benchmarkCached(cache, Scheme(p...)); };
+
+	return configuration;
+}
+
+// the first chunkCount chunks of the world gathered into a single region
+// the sections still point into the region mappings, so this is cheap to build
+inline
+Region sampleRegion(std::vector<Region> const& regions, std::size_t chunkCount)
+{
+	Region sample;
+
+	for(auto& region : regions)
+	{
+		for(auto& chunk : region.chunks)
+		{
+			if(sample.chunks.size() == chunkCount)
+				return sample;
+
+			sample.addChunk(chunk.index, chunk.sectionMask, chunk.firstSection);
+		}
+	}
+
+	return sample;
+}
+
+// chunkCount chunks spread evenly over the world, gathered into a single region
+inline
+Region spreadSample(std::vector<Region> const& regions, std::size_t chunkCount)
+{
+	std::vector<Chunk const*> chunks;
+
+	for(auto& region : regions)
+		for(auto& chunk : region.chunks)
+			chunks.push_back(&chunk);
+
+	Region sample;
+	chunkCount = std::min(chunkCount, chunks.size());
+
+	for(std::size_t i = 0; i != chunkCount; ++i)
+	{
+		auto& chunk = *chunks[i * chunks.size() / chunkCount];
+		sample.addChunk(chunk.index, chunk.sectionMask, chunk.firstSection);
+	}
+
+	return sample;
+}
+
+constexpr std::size_t CALIBRATION_CHUNKS = 32;
+
+inline
+std::vector<Region> calibrationSample(std::vector<Region> const& regions)
+{
+	return {sampleRegion(regions, CALIBRATION_CHUNKS)};
+}
+
+inline
+ChunkCache calibrationSample(ChunkCache const& cache)
+{
+	return cache.prefix(CALIBRATION_CHUNKS);
+}
+
+// a single stratum with the first chunks of the sample, standing for itself
+inline
+StratifiedSample calibrationSample(StratifiedSample const& sample)
+{
+	StratifiedSample calibration;
+	calibration.strata.push_back(sampleRegion(sample.strata, CALIBRATION_CHUNKS));
+	calibration.populations.push_back(calibration.strata[0].chunks.size());
+
+	for(auto section : calibration.strata[0].sections)
+		calibration.inputSize += BLOCKS_PER_SECTION * sizeof *section;
+
+	return calibration;
+}
+
+inline
+BenchmarkResult runConfiguration(Configuration const& configuration, std::vector<Region> const& regions)
+{
+	return configuration.benchmark(regions);
+}
+
+inline
+BenchmarkResult runConfiguration(Configuration const& configuration, ChunkCache const& cache)
+{
+	return configuration.benchmarkCached(cache);
+}
+
+inline
+BenchmarkResult runConfiguration(Configuration const& configuration, StratifiedSample const& sample)
+{
+	return configuration.benchmarkSampled(sample);
+}
+
+// runs every configuration over the shared, read-only input (regions, cached payloads or a stratified sample) with one configuration per
+// worker at a time
+// the configurations are timed on a small sample first and started in order of decreasing cost, so the slowest ones
+// don't end up running alone at the end of the sweep
+// every configuration is repeated on the worker that picked it up, its spread includes the interference of the
+// configurations running next to it
+template <typename Input>
+std::vector<BenchmarkResult> sweep(Input const& input, std::vector<Configuration> const& configurations, std::size_t threads,
+                                   Repetitions const& repetitions = {})
+{
+	auto sample = calibrationSample(input);
+	std::vector<float> costs(configurations.size());
+
+	for(std::size_t i = 0; i != configurations.size(); ++i)
+		costs[i] = runConfiguration(configurations[i], sample).cpuTime;
+
+	std::vector<std::size_t> order(configurations.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return costs[a] > costs[b]; });
+
+	std::vector<BenchmarkResult> results(configurations.size());
+	std::atomic<std::size_t> next{0};
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	runWorkers(std::min(threads, configurations.size()), [&](std::size_t)
+	{
+		for(auto i = next++; i < order.size(); i = next++)
+		{
+			auto& configuration = configurations[order[i]];
+			results[order[i]] = repeatBenchmark(repetitions, [&] { return runConfiguration(configuration, input); });
+		}
+	});
+
+	auto endTime = std::chrono::steady_clock::now();
+	auto duration = std::chrono::duration<float>(endTime - startTime).count();
+
+	// wall times of concurrent configurations include waiting for a core, so compare against cpu times
+	float totalTime = 0;
+	float slowestTime = 0;
+
+	for(auto& result : results)
+	{
+		printResult(result);
+		totalTime += result.cpuTime;
+		slowestTime = std::max(slowestTime, result.cpuTime);
+	}
+
+	std::printf("sweep: %zu configurations on %zu threads\n", configurations.size(), threads);
+	std::printf("wall: %.2f s, configuration cpu time: %.2f s total, %.2f s slowest\n", duration, totalTime, slowestTime);
+	std::printf("\n");
+
+	return results;
+}
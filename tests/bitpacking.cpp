@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstring>
 
 #include <gtest/gtest.h>
 
@@ -145,3 +146,120 @@ TEST(bitpacking, pack16to8)
 	ASSERT_EQ(buf[1], 0xbb);
 	ASSERT_EQ(buf[2], 0xff);
 }
+
+template <typename Pack, typename Unpack>
+void testRoundtrip(int bits, Pack pack, Unpack unpack)
+{
+	// 200 values leave a partially filled final word for every width that doesn't divide 8
+	constexpr std::size_t count = 200;
+	std::uint16_t in[count];
+
+	for(std::size_t i = 0; i != count; ++i)
+		in[i] = (i * 37 + 11) % (1 << bits);
+
+	std::uint8_t buf[2 * count + 8];
+	std::uint16_t out[count + 1];
+	out[count] = 0xffff;
+
+	auto packedSize = pack(in, count, buf);
+	auto unpackedSize = unpack(buf, count, out);
+	ASSERT_EQ(packedSize, unpackedSize);
+
+	for(std::size_t i = 0; i != count; ++i)
+		ASSERT_EQ(out[i], in[i]) << "at index " << i;
+
+	ASSERT_EQ(out[count], 0xffff);
+}
+
+TEST(bitpacking, roundtrip1)
+{
+	testRoundtrip(1, bitpack16to1, bitunpack1to16);
+}
+
+TEST(bitpacking, roundtrip2)
+{
+	testRoundtrip(2, bitpack16to2, bitunpack2to16);
+}
+
+TEST(bitpacking, roundtrip3)
+{
+	testRoundtrip(3, bitpack16to3, bitunpack3to16);
+}
+
+TEST(bitpacking, roundtrip4)
+{
+	testRoundtrip(4, bitpack16to4, bitunpack4to16);
+}
+
+TEST(bitpacking, roundtrip5)
+{
+	testRoundtrip(5, bitpack16to5, bitunpack5to16);
+}
+
+TEST(bitpacking, roundtrip6)
+{
+	testRoundtrip(6, bitpack16to6, bitunpack6to16);
+}
+
+TEST(bitpacking, roundtrip7)
+{
+	testRoundtrip(7, bitpack16to7, bitunpack7to16);
+}
+
+TEST(bitpacking, roundtrip8)
+{
+	testRoundtrip(8, bitpack16to8, bitunpack8to16);
+}
+
+TEST(bitpacking, roundtrip9to12)
+{
+	testRoundtrip(9, bitpack16toWords<9>, bitunpackWordsTo16<9>);
+	testRoundtrip(10, bitpack16toWords<10>, bitunpackWordsTo16<10>);
+	testRoundtrip(11, bitpack16toWords<11>, bitunpackWordsTo16<11>);
+	testRoundtrip(12, bitpack16toWords<12>, bitunpackWordsTo16<12>);
+}
+
+TEST(bitpacking, unpackOptimized_single)
+{
+	std::uint16_t out[8];
+
+	for(auto& elem : out)
+		elem = 0xffff;
+
+	auto size = bitunpackOptimized(1, nullptr, sizeof out / sizeof *out, out);
+	ASSERT_EQ(size, 0);
+
+	for(auto elem : out)
+		ASSERT_EQ(elem, 0);
+}
+
+TEST(bitpacking, vectorizedMatchesScalar)
+{
+	if(!bitpackVectorizedSupported())
+		GTEST_SKIP();
+
+	using Kernel = std::size_t (*)(std::uint16_t const*, std::size_t, std::uint8_t*);
+	Kernel scalar[] = {bitpack16to1, bitpack16to2, bitpack16to3, bitpack16to4, bitpack16to5, bitpack16to6, bitpack16to7, bitpack16to8};
+	Kernel vectorized[] = {bitpack16to1Vectorized, bitpack16to2Vectorized, bitpack16to3Vectorized, bitpack16to4Vectorized,
+	                       bitpack16to5Vectorized, bitpack16to6Vectorized, bitpack16to7Vectorized, bitpack16to8Vectorized};
+
+	std::uint16_t in[4096];
+
+	// 4096 is what sections use, 4000 leaves a scalar tail after the vectorized blocks for every width
+	for(std::size_t count : {4096, 4000})
+	{
+		for(int bits = 1; bits <= 8; ++bits)
+		{
+			for(std::size_t i = 0; i != count; ++i)
+				in[i] = (i * 7919 + i / 13) % (1 << bits);
+
+			std::uint8_t expected[4096 + 8];
+			std::uint8_t actual[4096 + 8];
+			auto expectedSize = scalar[bits - 1](in, count, expected);
+			auto actualSize = vectorized[bits - 1](in, count, actual);
+
+			ASSERT_EQ(actualSize, expectedSize) << bits << " bits, " << count << " values";
+			ASSERT_EQ(std::memcmp(actual, expected, expectedSize), 0) << bits << " bits, " << count << " values";
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../blockorder.hpp"
+#include "../palettepack.hpp"
+#include "../rlepack.hpp"
+
+void testPermutation(BlockOrder order)
+{
+	auto table = blockOrderTable(order);
+	std::vector<bool> seen(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+	{
+		ASSERT_LT(table[i], BLOCKS_PER_SECTION);
+		ASSERT_FALSE(seen[table[i]]);
+		seen[table[i]] = true;
+	}
+}
+
+int distance(std::uint16_t a, std::uint16_t b)
+{
+	return std::abs((a & 15) - (b & 15)) + std::abs((a >> 4 & 15) - (b >> 4 & 15)) + std::abs((a >> 8) - (b >> 8));
+}
+
+TEST(blockorder, morton)
+{
+	testPermutation(BlockOrder::morton);
+
+	// the first 8 blocks fill the 2x2x2 cube at the origin, x first
+	auto table = blockOrderTable(BlockOrder::morton);
+	ASSERT_EQ(table[1], sectionIndex(1, 0, 0));
+	ASSERT_EQ(table[2], sectionIndex(0, 0, 1));
+	ASSERT_EQ(table[4], sectionIndex(0, 1, 0));
+	ASSERT_EQ(table[7], sectionIndex(1, 1, 1));
+	ASSERT_EQ(table[BLOCKS_PER_SECTION - 1], sectionIndex(15, 15, 15));
+}
+
+TEST(blockorder, hilbert)
+{
+	testPermutation(BlockOrder::hilbert);
+
+	auto table = blockOrderTable(BlockOrder::hilbert);
+
+	for(std::size_t i = 1; i != BLOCKS_PER_SECTION; ++i)
+		ASSERT_EQ(distance(table[i - 1], table[i]), 1);
+}
+
+TEST(blockorder, roundtrip)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != data.size(); ++i)
+		data[i] = (i * 7919) % 13 < 3 ? i % 5 : 0;
+
+	for(auto order : {BlockOrder::linear, BlockOrder::morton, BlockOrder::hilbert})
+	{
+		std::vector<std::uint8_t> encoded(MAX_RLE_SECTION_SIZE);
+		std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION);
+
+		auto size = encodeSection(data.data(), encoded.data(), PaletteOrder::firstSeen, order);
+		ASSERT_EQ(decodeSection(encoded.data(), decoded.data(), order), size);
+		ASSERT_EQ(decoded, data);
+
+		size = encodeSectionRle(data.data(), encoded.data(), PaletteOrder::firstSeen, order);
+		ASSERT_EQ(decodeSectionRle(encoded.data(), decoded.data(), order), size);
+		ASSERT_EQ(decoded, data);
+	}
+}
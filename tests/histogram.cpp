@@ -0,0 +1,48 @@
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "../histogram.hpp"
+
+TEST(histogram, exactSmallValues)
+{
+	LatencyHistogram histogram;
+
+	for(std::uint64_t i = 1; i <= 20; ++i)
+		histogram.record(i);
+
+	ASSERT_EQ(histogram.count(), 20);
+	ASSERT_EQ(histogram.percentile(0.5), 10);
+	ASSERT_EQ(histogram.percentile(1), 20);
+	ASSERT_EQ(histogram.max(), 20);
+}
+
+TEST(histogram, relativeError)
+{
+	LatencyHistogram histogram;
+
+	for(std::uint64_t i = 1; i <= 100000; ++i)
+		histogram.record(i * 37);
+
+	for(double fraction : {0.5, 0.9, 0.99, 0.999})
+	{
+		double expected = fraction * 100000 * 37;
+		double actual = histogram.percentile(fraction);
+		ASSERT_GE(actual, expected * (1 - 1 / 32.));
+		ASSERT_LE(actual, expected * (1 + 1 / 32.));
+	}
+
+	ASSERT_EQ(histogram.percentile(1), 100000 * 37);
+}
+
+TEST(histogram, merge)
+{
+	LatencyHistogram a, b;
+	a.record(5);
+	b.record(1'000'000);
+	a.merge(b);
+
+	ASSERT_EQ(a.count(), 2);
+	ASSERT_EQ(a.percentile(0.5), 5);
+	ASSERT_EQ(a.max(), 1'000'000);
+}
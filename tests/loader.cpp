@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "../loader.hpp"
+
+TEST(loader, regionFilenames)
+{
+	ASSERT_TRUE(isRegionFilename("0.0.bin"));
+	ASSERT_TRUE(isRegionFilename("-12.345.bin"));
+	ASSERT_TRUE(isRegionFilename("7.-1.bin"));
+
+	ASSERT_FALSE(isRegionFilename(""));
+	ASSERT_FALSE(isRegionFilename("0.bin"));
+	ASSERT_FALSE(isRegionFilename("0.0.bin.tmp"));
+	ASSERT_FALSE(isRegionFilename("r.0.0.bin"));
+	ASSERT_FALSE(isRegionFilename("-.0.bin"));
+	ASSERT_FALSE(isRegionFilename("1.2.mca"));
+	ASSERT_FALSE(isRegionFilename("1..2.bin"));
+}
+
+TEST(loader, regionCoordinates)
+{
+	int x, z;
+	ASSERT_TRUE(parseRegionFilename("-12.345.bin", x, z));
+	ASSERT_EQ(x, -12);
+	ASSERT_EQ(z, 345);
+}
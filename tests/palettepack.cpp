@@ -0,0 +1,108 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../palettepack.hpp"
+
+// blocks in runs of varying length drawn from the given number of distinct ids
+void fillSection(std::uint16_t* data, std::size_t count, std::size_t distincts)
+{
+	for(std::size_t i = 0; i != count; ++i)
+		data[i] = 100 + (i / (1 + i % 7) * 31) % distincts;
+}
+
+void testPalettizeAndPack(bool vanilla)
+{
+	constexpr std::size_t count = 4096;
+
+	for(std::size_t distincts : {1, 2, 3, 4, 7, 16, 20, 33, 64, 100, 200, 300, 1000, 4000})
+	{
+		std::uint16_t data[count];
+		fillSection(data, count, distincts);
+
+		auto palette = createPalette(data, count, false);
+
+		std::uint16_t buf[count];
+		palettize(palette, data, count, buf, false);
+
+		std::uint8_t expected[2 * count + 8];
+		std::uint8_t actual[2 * count + 8];
+
+		auto expectedSize = vanilla
+			? bitpackVanilla(palette.size, buf, count, expected, false)
+			: bitpackOptimized(palette.size, buf, count, expected, false);
+
+		auto actualSize = vanilla
+			? palettizeAndPackVanilla(palette, data, count, actual)
+			: palettizeAndPackOptimized(palette, data, count, actual);
+
+		ASSERT_EQ(actualSize, expectedSize) << distincts << " distinct values";
+		ASSERT_EQ(std::memcmp(actual, expected, expectedSize), 0) << distincts << " distinct values";
+	}
+}
+
+TEST(palettepack, optimized)
+{
+	testPalettizeAndPack(false);
+}
+
+TEST(palettepack, vanilla)
+{
+	testPalettizeAndPack(true);
+}
+
+TEST(palettepack, partialWord)
+{
+	std::uint16_t data[] = {5, 5, 9, 5, 9, 9, 5, 9, 5};
+	Palette palette;
+	palette.size = 2;
+	palette.values[0] = 5;
+	palette.values[1] = 9;
+
+	std::uint16_t buf[9];
+	palettize(palette, data, 8, buf, false);
+
+	std::uint8_t expected[2] = {0, 0xff};
+	std::uint8_t actual[2] = {0, 0xff};
+	ASSERT_EQ(palettizeAndPack<1>(palette, data, 8, actual), bitpack16to1(buf, 8, expected));
+	ASSERT_EQ(actual[0], 0b1011'0100);
+	ASSERT_EQ(actual[0], expected[0]);
+	ASSERT_EQ(actual[1], 0xff);
+}
+
+TEST(palettepack, sectionRoundtrip)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	for(std::size_t distincts : {1, 2, 17, 300, 4096})
+	{
+		for(std::size_t i = 0; i != data.size(); ++i)
+			data[i] = (i * 7919) % distincts * 3;
+
+		std::vector<std::uint8_t> encoded(MAX_ENCODED_SECTION_SIZE);
+		std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION);
+
+		auto size = encodeSection(data.data(), encoded.data());
+		ASSERT_LE(size, MAX_ENCODED_SECTION_SIZE);
+		ASSERT_EQ(decodeSection(encoded.data(), decoded.data()), size) << distincts << " distinct values";
+		ASSERT_EQ(decoded, data) << distincts << " distinct values";
+	}
+}
+
+TEST(palettepack, packedSize)
+{
+	for(std::size_t distincts : {2, 3, 5, 17, 100, 1000, 4000})
+	{
+		std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+		for(std::size_t i = 0; i != data.size(); ++i)
+			data[i] = i % distincts;
+
+		auto palette = createPalette(data.data(), data.size(), false);
+		std::vector<std::uint8_t> out(MAX_ENCODED_SECTION_SIZE);
+
+		ASSERT_EQ(packedSize(ceillog2(palette.size), data.size()), palettizeAndPackOptimized(palette, data.data(), data.size(), out.data()));
+	}
+}
@@ -63,3 +63,126 @@ TEST(palettization, palettize_fast)
 {
 	testPalettize(true);
 }
+
+TEST(palettization, depalettize)
+{
+	Palette palette;
+	palette.size = 3;
+	palette.values[0] = 9;
+	palette.values[1] = 4;
+	palette.values[2] = 0;
+
+	std::uint16_t in[] = {0, 0, 2, 1, 0};
+	std::uint16_t out[6];
+	out[5] = 0xff;
+	depalettize(palette, in, 5, out);
+
+	ASSERT_EQ(out[0], 9);
+	ASSERT_EQ(out[1], 9);
+	ASSERT_EQ(out[2], 0);
+	ASSERT_EQ(out[3], 4);
+	ASSERT_EQ(out[4], 9);
+	ASSERT_EQ(out[5], 0xff);
+}
+
+TEST(palettization, serialization)
+{
+	Palette palette;
+	palette.size = 3;
+	palette.values[0] = 9;
+	palette.values[1] = 0x1234;
+	palette.values[2] = 0;
+
+	std::uint8_t buf[16];
+	auto written = writePalette(palette, buf);
+	ASSERT_EQ(written, 8);
+
+	Palette result;
+	auto read = readPalette(buf, &result);
+	ASSERT_EQ(read, written);
+	ASSERT_EQ(result.size, 3);
+	ASSERT_EQ(result.values[0], 9);
+	ASSERT_EQ(result.values[1], 0x1234);
+	ASSERT_EQ(result.values[2], 0);
+}
+
+void testLargePalette(bool vectorize)
+{
+	// more distinct values than the vectorized version and the original 256 entry limit can handle
+	constexpr std::size_t count = 4096;
+	std::uint16_t data[count];
+
+	for(std::size_t i = 0; i != count; ++i)
+		data[i] = (i % 1000) * 3 + 1;
+
+	auto palette = createPalette(data, count, vectorize);
+	ASSERT_EQ(palette.size, 1000);
+
+	for(std::size_t i = 0; i != 1000; ++i)
+		ASSERT_EQ(palette.values[i], i * 3 + 1);
+
+	std::uint16_t indices[count];
+	palettize(palette, data, count, indices, vectorize);
+
+	for(std::size_t i = 0; i != count; ++i)
+		ASSERT_EQ(indices[i], i % 1000);
+}
+
+TEST(palettization, largePalette_slow)
+{
+	testLargePalette(false);
+}
+
+TEST(palettization, largePalette_fast)
+{
+	testLargePalette(true);
+}
+
+TEST(palettization, createPalette_repeated)
+{
+	// the bitmap must not remember values from previous calls
+	std::uint16_t first[] = {4, 5, 6};
+	std::uint16_t second[] = {6, 5, 7};
+
+	auto palette1 = createPalette(first, 3, false);
+	auto palette2 = createPalette(second, 3, false);
+	ASSERT_EQ(palette1.size, 3);
+	ASSERT_EQ(palette2.size, 3);
+	ASSERT_EQ(palette2.values[0], 6);
+	ASSERT_EQ(palette2.values[1], 5);
+	ASSERT_EQ(palette2.values[2], 7);
+}
+
+TEST(palettization, createPalette_frequency)
+{
+	// 40 blocks so both the uniform 16 block stretches and the remainder are counted
+	std::uint16_t data[40];
+
+	for(std::size_t i = 0; i != 40; ++i)
+		data[i] = i < 4 ? 9 : i < 10 ? 5 : 2;
+
+	data[39] = 5;
+
+	auto palette = createPalette(data, 40, true, PaletteOrder::frequency);
+	ASSERT_EQ(palette.size, 3);
+	ASSERT_EQ(palette.values[0], 2);
+	ASSERT_EQ(palette.values[1], 5);
+	ASSERT_EQ(palette.values[2], 9);
+
+	std::uint32_t counts[3] = {};
+	countPaletteEntries(palette, data, 40, counts);
+	ASSERT_EQ(counts[0], 29);
+	ASSERT_EQ(counts[1], 7);
+	ASSERT_EQ(counts[2], 4);
+}
+
+TEST(palettization, sortPaletteByCounts_stable)
+{
+	std::uint16_t data[] = {3, 1, 2};
+	auto palette = createPalette(data, 3, false);
+	std::uint32_t counts[] = {1, 2, 1};
+	sortPaletteByCounts(palette, counts);
+	ASSERT_EQ(palette.values[0], 1);
+	ASSERT_EQ(palette.values[1], 3);
+	ASSERT_EQ(palette.values[2], 2);
+}
@@ -0,0 +1,24 @@
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../pareto.hpp"
+
+TEST(pareto, frontier)
+{
+	std::vector<ParetoPoint> points =
+	{
+		{1, 10},
+		{2, 5},
+		{1.5, 4},
+		{3, 1},
+		{2, 5},
+		{0.5, 10},
+	};
+
+	// 2 is dominated by 1, 4 duplicates 1 and 5 is dominated by 0
+	ASSERT_EQ(paretoFrontier(points), (std::vector<std::size_t>{0, 1, 3}));
+	ASSERT_TRUE(dominates(points[1], points[2]));
+	ASSERT_FALSE(dominates(points[1], points[4]));
+}
@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../predictpack.hpp"
+
+std::uint8_t roundtripPredicted(std::vector<std::uint16_t> const& data, std::uint16_t const* predictor)
+{
+	std::vector<std::uint8_t> encoded(MAX_PREDICTED_SECTION_SIZE);
+	auto size = encodeSectionPredicted(data.data(), predictor, encoded.data());
+
+	std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION);
+	EXPECT_EQ(decodeSectionPredicted(encoded.data(), predictor, decoded.data()), size);
+	EXPECT_EQ(decoded, data);
+	return encoded[0];
+}
+
+TEST(predictpack, withoutPredictor)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != data.size(); ++i)
+		data[i] = i % 3;
+
+	ASSERT_EQ(roundtripPredicted(data, nullptr), PREDICTION_NONE);
+}
+
+TEST(predictpack, same)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != data.size(); ++i)
+		data[i] = i * 7 % 300;
+
+	ASSERT_EQ(roundtripPredicted(data, data.data()), PREDICTION_SAME);
+}
+
+TEST(predictpack, exceptions)
+{
+	// many distinct blocks, of which only a few differ from the predictor, including the first and last one
+	std::vector<std::uint16_t> predictor(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != predictor.size(); ++i)
+		predictor[i] = i * 7 % 300;
+
+	auto data = predictor;
+
+	for(std::size_t i = 0; i < data.size(); i += 61)
+		data[i] = 1000 + i % 3;
+
+	data.back() = 1002;
+
+	ASSERT_EQ(roundtripPredicted(data, predictor.data()), PREDICTION_EXCEPTIONS);
+}
+
+TEST(predictpack, unrelated)
+{
+	// with nothing in common, the section is stored on its own
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION, 5);
+	std::vector<std::uint16_t> predictor(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != predictor.size(); ++i)
+		predictor[i] = i % 11;
+
+	ASSERT_EQ(roundtripPredicted(data, predictor.data()), PREDICTION_NONE);
+}
+
+TEST(predictpack, unrelatedMaxBlock)
+{
+	// 0xffff is a valid block id, which the palette of the section stored on its own must keep
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION, 7);
+	std::vector<std::uint16_t> predictor(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i < data.size(); i += 50)
+		data[i] = 0xffff;
+
+	for(std::size_t i = 0; i != predictor.size(); ++i)
+		predictor[i] = i % 11;
+
+	ASSERT_EQ(roundtripPredicted(data, predictor.data()), PREDICTION_NONE);
+}
@@ -0,0 +1,95 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../results.hpp"
+
+BenchmarkResult makeResult(std::string const& scheme, std::size_t size, float time)
+{
+	BenchmarkResult result;
+	result.scheme = scheme;
+	result.inputSize = 1 << 20;
+	result.size = size;
+	result.time = time;
+	result.cpuTime = time;
+	return result;
+}
+
+void testRoundtrip(char const* extension)
+{
+	// names that need quoting or escaping in csv and json
+	std::vector<std::string> names = {"opt2:zstd/3", "a,b:c", "say \"hi\"", "back\\slash", "\"quoted,\\\""};
+
+	ResultWriter writer;
+
+	for(std::size_t i = 0; i != names.size(); ++i)
+		writer.add(makeResult(names[i], 1000 + i, 0.5f), i % 2 ? "cached" : "full");
+
+	auto path = fs::temp_directory_path() / (std::string("results_test") + extension);
+	writer.write(path);
+	auto records = readResults(path);
+	fs::remove(path);
+
+	ASSERT_EQ(records.size(), names.size()) << extension;
+
+	for(std::size_t i = 0; i != names.size(); ++i)
+	{
+		ASSERT_EQ(records[i]["name"], names[i]) << extension;
+		ASSERT_EQ(records[i]["mode"], i % 2 ? "cached" : "full") << extension;
+		ASSERT_EQ(records[i]["output_bytes"], std::to_string(1000 + i)) << extension;
+		ASSERT_EQ(resultNumber(records[i], "mib_per_second"), 2) << extension;
+	}
+
+	ASSERT_EQ(records[0]["scheme"], "opt2");
+	ASSERT_EQ(records[0]["compressor"], "zstd");
+	ASSERT_EQ(records[0]["level"], "3");
+}
+
+TEST(results, csv)
+{
+	testRoundtrip(".csv");
+}
+
+TEST(results, json)
+{
+	testRoundtrip(".json");
+}
+
+TEST(results, regression)
+{
+	std::map<std::string, std::string> baseline = {{"ratio", "10"}, {"mib_per_second", "100"}, {"repetitions", "1"}};
+
+	auto candidate = baseline;
+	ASSERT_FALSE(isRegression(baseline, candidate, 5));
+
+	// changes within the threshold and improvements aren't regressions
+	candidate["ratio"] = "9.6";
+	candidate["mib_per_second"] = "200";
+	ASSERT_FALSE(isRegression(baseline, candidate, 5));
+
+	candidate["ratio"] = "9.4";
+	ASSERT_TRUE(isRegression(baseline, candidate, 5));
+	ASSERT_FALSE(isRegression(baseline, candidate, 10));
+
+	candidate["ratio"] = "10";
+	candidate["mib_per_second"] = "90";
+	ASSERT_TRUE(isRegression(baseline, candidate, 5));
+	ASSERT_FALSE(isRegression(baseline, candidate, 15));
+}
+
+TEST(results, overlappingSlowdown)
+{
+	std::map<std::string, std::string> baseline = {{"ratio", "10"}, {"mib_per_second", "100"}, {"repetitions", "5"},
+	                                               {"wall_mean_seconds", "1"}, {"wall_ci95_seconds", "0.1"}};
+
+	// slower beyond the threshold, but within the noise of both runs
+	auto candidate = baseline;
+	candidate["mib_per_second"] = "90";
+	candidate["wall_mean_seconds"] = "1.1";
+	ASSERT_FALSE(isRegression(baseline, candidate, 5));
+
+	candidate["wall_mean_seconds"] = "1.3";
+	ASSERT_TRUE(isRegression(baseline, candidate, 5));
+}
@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../rlepack.hpp"
+
+std::uint8_t roundtripRle(std::vector<std::uint16_t> const& data)
+{
+	std::vector<std::uint8_t> encoded(MAX_RLE_SECTION_SIZE);
+	auto size = encodeSectionRle(data.data(), encoded.data());
+
+	std::vector<std::uint16_t> decoded(BLOCKS_PER_SECTION);
+	EXPECT_EQ(decodeSectionRle(encoded.data(), decoded.data()), size);
+	EXPECT_EQ(decoded, data);
+	return encoded[0];
+}
+
+TEST(rlepack, layers)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	// a few horizontal layers, which are long runs in y, z, x order
+	for(std::size_t i = 0; i != data.size(); ++i)
+		data[i] = i < 1024 ? 7 : i < 3000 ? 1 : 0;
+
+	ASSERT_EQ(roundtripRle(data), SECTION_RUNS);
+}
+
+TEST(rlepack, sparse)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION, 1);
+
+	// stone with scattered ores, including the first and last block
+	for(std::size_t i = 0; i < data.size(); i += 97)
+		data[i] = 14 + i % 3;
+
+	data.back() = 16;
+
+	ASSERT_EQ(roundtripRle(data), SECTION_SPARSE);
+}
+
+TEST(rlepack, packed)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION);
+
+	for(std::size_t i = 0; i != data.size(); ++i)
+		data[i] = (i * 2654435761u >> 7) % 300;
+
+	ASSERT_EQ(roundtripRle(data), SECTION_PACKED);
+}
+
+TEST(rlepack, maxBlock)
+{
+	std::vector<std::uint16_t> data(BLOCKS_PER_SECTION, 7);
+
+	// 0xffff is a valid block id, which the palette must not confuse with padding
+	for(std::size_t i = 0; i < data.size(); i += 50)
+		data[i] = 0xffff;
+
+	roundtripRle(data);
+}
+
+TEST(rlepack, uniform)
+{
+	roundtripRle(std::vector<std::uint16_t>(BLOCKS_PER_SECTION, 9));
+}
+
+TEST(rlepack, varint)
+{
+	for(std::uint32_t value : {0u, 1u, 127u, 128u, 4095u, 16384u, 1u << 31})
+	{
+		std::uint8_t buffer[8];
+		auto size = writeVarint(value, buffer);
+		std::uint32_t read;
+
+		ASSERT_EQ(size, varintSize(value));
+		ASSERT_EQ(readVarint(buffer, read), size);
+		ASSERT_EQ(read, value);
+	}
+}
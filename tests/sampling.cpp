@@ -0,0 +1,25 @@
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../sampling.hpp"
+
+TEST(sampling, fullySampledStratum)
+{
+	auto estimate = estimateTotal({{1, 2, 3}}, {3});
+
+	ASSERT_DOUBLE_EQ(estimate.total, 6);
+	ASSERT_DOUBLE_EQ(estimate.error, 0);
+}
+
+TEST(sampling, extrapolation)
+{
+	// means of 2 and 10, scaled to populations of 100 and 10
+	auto estimate = estimateTotal({{1, 3}, {10, 10}}, {100, 10});
+
+	ASSERT_DOUBLE_EQ(estimate.total, 300);
+	// 100^2 * (1 - 2/100) * 2 / 2, the second stratum doesn't vary
+	ASSERT_NEAR(estimate.error, 1.96 * std::sqrt(9800.), 1e-9);
+}
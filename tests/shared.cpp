@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../compressors/null.hpp"
+#include "../schemes/shared.hpp"
+
+using Sections = std::vector<std::vector<std::uint16_t>>;
+
+// encodes the sections as one chunk and decodes it again, returns the mask of sections with their own palette
+std::uint16_t roundtripShared(Sections const& sections, PaletteOrder order, std::size_t* chunkPaletteSize = nullptr)
+{
+	std::vector<std::uint16_t const*> pointers;
+
+	for(auto& section : sections)
+		pointers.push_back(section.data());
+
+	Chunk chunk;
+	chunk.firstSection = pointers.data();
+	chunk.sectionCount = sections.size();
+	chunk.sectionMask = (1 << sections.size()) - 1;
+
+	SharedPaletteCompressionScheme<NullCompressor> scheme(order, BlockOrder::linear);
+	scheme.beginChunk(chunk);
+	auto ownPaletteMask = scheme._ownPaletteMask;
+
+	if(chunkPaletteSize)
+		*chunkPaletteSize = scheme._chunkPalette.size;
+
+	for(auto pointer : pointers)
+		scheme.section(pointer);
+
+	auto size = scheme.endChunk();
+
+	std::vector<std::uint16_t> decoded(sections.size() * BLOCKS_PER_SECTION);
+	scheme.decodeChunk(scheme.compressedChunk(), size, sections.size(), decoded.data());
+
+	for(std::size_t i = 0; i != sections.size(); ++i)
+		EXPECT_TRUE(std::equal(sections[i].begin(), sections[i].end(), decoded.begin() + i * BLOCKS_PER_SECTION));
+
+	return ownPaletteMask;
+}
+
+TEST(shared, ownPalettes)
+{
+	for(auto order : {PaletteOrder::firstSeen, PaletteOrder::frequency})
+	{
+		// uniform sections are smaller on their own, the varied ones share the chunk palette
+		Sections sections(4, std::vector<std::uint16_t>(BLOCKS_PER_SECTION, 1));
+
+		for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+		{
+			sections[0][i] = i % 130;
+			sections[2][i] = i % 130 == 0 ? 0xffff : 100 + i % 130;
+		}
+
+		sections[3].assign(BLOCKS_PER_SECTION, 0xffff);
+
+		ASSERT_EQ(roundtripShared(sections, order), 0b1010);
+	}
+}
+
+TEST(shared, tooManyBlocks)
+{
+	for(auto order : {PaletteOrder::firstSeen, PaletteOrder::frequency})
+	{
+		// more distinct blocks than a palette holds, every section keeps its own
+		Sections sections(3, std::vector<std::uint16_t>(BLOCKS_PER_SECTION));
+
+		for(std::size_t s = 0; s != sections.size(); ++s)
+			for(std::size_t i = 0; i != BLOCKS_PER_SECTION; ++i)
+				sections[s][i] = 0xffff - (s * 2000 + i % 2000);
+
+		ASSERT_EQ(roundtripShared(sections, order), 0b111);
+	}
+}
+
+TEST(shared, emptyChunkPalette)
+{
+	for(auto order : {PaletteOrder::firstSeen, PaletteOrder::frequency})
+	{
+		// uniform sections of different blocks, none of them uses the chunk palette
+		Sections sections;
+
+		for(std::uint16_t value : {0, 1, 0xffff})
+			sections.emplace_back(BLOCKS_PER_SECTION, value);
+
+		std::size_t chunkPaletteSize;
+		ASSERT_EQ(roundtripShared(sections, order, &chunkPaletteSize), 0b111);
+		ASSERT_EQ(chunkPaletteSize, 0);
+	}
+}
+
+TEST(shared, noSections)
+{
+	// chunks with an empty section mask are valid input
+	for(auto order : {PaletteOrder::firstSeen, PaletteOrder::frequency})
+	{
+		std::size_t chunkPaletteSize;
+		ASSERT_EQ(roundtripShared(Sections(), order, &chunkPaletteSize), 0);
+		ASSERT_EQ(chunkPaletteSize, 0);
+	}
+}
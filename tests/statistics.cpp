@@ -0,0 +1,29 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../statistics.hpp"
+
+TEST(statistics, summary)
+{
+	auto statistics = summarize({4, 1, 3, 2});
+
+	ASSERT_EQ(statistics.count, 4);
+	ASSERT_DOUBLE_EQ(statistics.mean, 2.5);
+	ASSERT_DOUBLE_EQ(statistics.median, 2.5);
+	ASSERT_DOUBLE_EQ(statistics.min, 1);
+	ASSERT_DOUBLE_EQ(statistics.max, 4);
+	ASSERT_NEAR(statistics.stddev, 1.2910, 1e-4);
+	// t(3) = 3.182, standard error 1.2910 / 2
+	ASSERT_NEAR(statistics.confidence, 2.0540, 1e-3);
+}
+
+TEST(statistics, singleSample)
+{
+	auto statistics = summarize({7});
+
+	ASSERT_EQ(statistics.count, 1);
+	ASSERT_DOUBLE_EQ(statistics.median, 7);
+	ASSERT_DOUBLE_EQ(statistics.stddev, 0);
+	ASSERT_DOUBLE_EQ(statistics.confidence, 0);
+}
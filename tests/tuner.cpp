@@ -0,0 +1,32 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../tuner.hpp"
+
+TEST(tuner, parseTarget)
+{
+	auto target = parseTuningTarget("compress>=400,decompress>=1000.5,maximize=decompress");
+
+	ASSERT_DOUBLE_EQ(target.minCompressSpeed, 400);
+	ASSERT_DOUBLE_EQ(target.minDecompressSpeed, 1000.5);
+	ASSERT_DOUBLE_EQ(target.minRatio, 0);
+	ASSERT_EQ(target.maximize, "decompress");
+
+	ASSERT_EQ(parseTuningTarget("").maximize, "ratio");
+}
+
+TEST(tuner, recommend)
+{
+	std::vector<TuningCandidate> candidates =
+	{
+		{"fast", 40, 900, 2000},
+		{"balanced", 50, 450, 1500},
+		{"small", 60, 20, 1200},
+	};
+
+	ASSERT_EQ(recommend(candidates, parseTuningTarget("compress>=400")), 1);
+	ASSERT_EQ(recommend(candidates, parseTuningTarget("")), 2);
+	ASSERT_EQ(recommend(candidates, parseTuningTarget("ratio>=45,maximize=compress")), 1);
+	ASSERT_EQ(recommend(candidates, parseTuningTarget("compress>=1000")), -1);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+// distributes the indices [0, itemCount) over a fixed number of workers
+// each worker starts on its own contiguous slice and steals from the other slices once its own is exhausted
+class WorkStealingRange
+{
+	struct alignas(64) Slice
+	{
+		std::atomic<std::size_t> next;
+		std::size_t end;
+	};
+
+	std::unique_ptr<Slice[]> _slices;
+	std::size_t _workerCount;
+
+public:
+	WorkStealingRange(std::size_t workerCount, std::size_t itemCount)
+	: _slices(new Slice[workerCount])
+	, _workerCount(workerCount)
+	{
+		for(std::size_t i = 0; i != workerCount; ++i)
+		{
+			_slices[i].next = itemCount * i / workerCount;
+			_slices[i].end = itemCount * (i + 1) / workerCount;
+		}
+	}
+
+	bool next(std::size_t worker, std::size_t& item)
+	{
+		for(std::size_t i = 0; i != _workerCount; ++i)
+		{
+			auto& slice = _slices[(worker + i) % _workerCount];
+
+			if(slice.next.load(std::memory_order_relaxed) >= slice.end)
+				continue;
+
+			item = slice.next.fetch_add(1, std::memory_order_relaxed);
+
+			if(item < slice.end)
+				return true;
+		}
+
+		return false;
+	}
+};
+
+// runs worker(i) for every i in [0, threadCount) on its own thread and waits for all of them to finish
+// worker 0 runs on the calling thread
+template <typename Worker>
+void runWorkers(std::size_t threadCount, Worker worker)
+{
+	std::vector<std::thread> threads;
+
+	for(std::size_t i = 1; i < threadCount; ++i)
+		threads.emplace_back([&worker, i] { worker(i); });
+
+	worker(0);
+
+	for(auto& thread : threads)
+		thread.join();
+}
+
+// restricts the calling thread to a single core, so it isn't migrated between cores in the middle of a measurement
+// returns false if the core doesn't exist or isn't available to the process
+inline
+bool pinThread(std::size_t core)
+{
+	if(core >= CPU_SETSIZE)
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	return sched_setaffinity(0, sizeof set, &set) == 0;
+}
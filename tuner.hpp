@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "loader.hpp"
+#include "pareto.hpp"
+
+// the constraints a configuration has to meet and the quantity to make as large as possible among those that do
+// speeds are in MiB/s of raw section data
+struct TuningTarget
+{
+	double minRatio = 0;
+	double minCompressSpeed = 0;
+	double minDecompressSpeed = 0;
+	std::string maximize = "ratio";
+};
+
+// comma separated constraints and an optional objective, e.g. "compress>=400" or "ratio>=50,maximize=decompress"
+inline
+TuningTarget parseTuningTarget(std::string const& text)
+{
+	TuningTarget target;
+	std::size_t start = 0;
+
+	while(start <= text.size())
+	{
+		auto end = std::min(text.find(',', start), text.size());
+		auto item = text.substr(start, end - start);
+		auto at = item.find(">=");
+
+		if(item.compare(0, 9, "maximize=") == 0)
+		{
+			target.maximize = item.substr(9);
+
+			if(target.maximize != "ratio" && target.maximize != "compress" && target.maximize != "decompress")
+				fatalError("invalid tuning objective '%s', expected ratio, compress or decompress\n", target.maximize.c_str());
+		}
+		else if(at != std::string::npos)
+		{
+			auto key = item.substr(0, at);
+			char* p;
+			auto value = std::strtod(item.c_str() + at + 2, &p);
+
+			if(*p != '\0' || p == item.c_str() + at + 2)
+				fatalError("invalid tuning target '%s'\n", text.c_str());
+
+			if(key == "ratio")
+				target.minRatio = value;
+			else if(key == "compress")
+				target.minCompressSpeed = value;
+			else if(key == "decompress")
+				target.minDecompressSpeed = value;
+			else
+				fatalError("invalid tuning constraint '%s', expected ratio, compress or decompress\n", key.c_str());
+		}
+		else if(!item.empty())
+			fatalError("invalid tuning target '%s'\n", text.c_str());
+
+		start = end + 1;
+	}
+
+	return target;
+}
+
+// the measurements of one configuration the tuner decides on
+struct TuningCandidate
+{
+	std::string name;
+	double ratio;
+	double compressSpeed;
+	double decompressSpeed;
+};
+
+inline
+double objective(TuningCandidate const& candidate, TuningTarget const& target)
+{
+	if(target.maximize == "compress")
+		return candidate.compressSpeed;
+
+	if(target.maximize == "decompress")
+		return candidate.decompressSpeed;
+
+	return candidate.ratio;
+}
+
+// index of the candidate that meets the target with the largest objective, or -1 if none of them does
+// ties go to the faster compressor
+inline
+long recommend(std::vector<TuningCandidate> const& candidates, TuningTarget const& target)
+{
+	long best = -1;
+
+	for(std::size_t i = 0; i != candidates.size(); ++i)
+	{
+		auto& candidate = candidates[i];
+
+		if(candidate.ratio < target.minRatio || candidate.compressSpeed < target.minCompressSpeed
+		   || candidate.decompressSpeed < target.minDecompressSpeed)
+			continue;
+
+		if(best < 0 || objective(candidate, target) > objective(candidates[best], target)
+		   || (objective(candidate, target) == objective(candidates[best], target) && candidate.compressSpeed > candidates[best].compressSpeed))
+			best = i;
+	}
+
+	return best;
+}
+
+// prints both frontiers and the recommendation, the results of both lists belong to the same configurations
+// the decode results only contribute their speed, schemes reading single chunks don't decode the whole input
+inline
+void printTuning(std::vector<BenchmarkResult> const& compressResults, std::vector<BenchmarkResult> const& decompressResults,
+                 TuningTarget const& target)
+{
+	std::vector<TuningCandidate> candidates;
+	std::vector<std::string> names;
+	std::vector<ParetoPoint> compressPoints;
+	std::vector<ParetoPoint> decompressPoints;
+
+	for(std::size_t i = 0; i != compressResults.size(); ++i)
+	{
+		auto compress = compressionPoint(compressResults[i]);
+		auto decompress = compressionPoint(decompressResults[i]);
+		candidates.push_back({compressResults[i].scheme, compress.x, compress.y, decompress.y});
+		names.push_back(compressResults[i].scheme);
+		compressPoints.push_back(compress);
+		decompressPoints.push_back({compress.x, decompress.y});
+	}
+
+	printParetoFrontier(names, compressPoints, "ratio/compression speed");
+	printParetoFrontier(names, decompressPoints, "ratio/decompression speed");
+
+	std::printf("target: ratio >= %.2f, compress >= %.2f MiB/s, decompress >= %.2f MiB/s, maximize %s\n",
+	            target.minRatio, target.minCompressSpeed, target.minDecompressSpeed, target.maximize.c_str());
+
+	auto best = recommend(candidates, target);
+
+	if(best < 0)
+		std::printf("recommendation: none of the %zu configurations meets the target\n", candidates.size());
+	else
+	{
+		auto& candidate = candidates[best];
+		std::printf("recommendation: %s, ratio %.2f, compress %.2f MiB/s, decompress %.2f MiB/s\n", candidate.name.c_str(),
+		            candidate.ratio, candidate.compressSpeed, candidate.decompressSpeed);
+	}
+
+	std::printf("\n");
+}